@@ -0,0 +1,562 @@
+// Built with SCOPE_BENCH_COUNT_CALLS=1, it counts the calls to
+// std::uncaught_exceptions() made per operation, the runtime calls which
+// scope_frame and the scope groups save, instead of timing the operations.
+// The counting wrapper would distort the timings.
+#if SCOPE_BENCH_COUNT_CALLS
+#include <exception>
+
+namespace {
+long long uncaught_exceptions_calls = 0;
+int counted_uncaught_exceptions() noexcept {
+  ++uncaught_exceptions_calls;
+  return std::uncaught_exceptions();
+}
+} // namespace
+#define SCOPE_UNCAUGHT_EXCEPTIONS() counted_uncaught_exceptions()
+#endif
+
+#include "scope.hpp"
+#include "scope_any.hpp"
+#include "scope_array.hpp"
+#include "scope_relocate.hpp"
+#include "scope_shared.hpp"
+#include "scope_stack.hpp"
+#include "scope_table.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Microbenchmarks for the guards and unique_resource against hand written
+// equivalents. Build with optimizations (e.g. -DCMAKE_BUILD_TYPE=Release),
+// otherwise the numbers are meaningless.
+//
+// Usage: benchmarks [iterations]
+//        benchmarks_calls
+
+namespace {
+using namespace scope;
+
+// Forces the compiler to materialize all memory writes done so far, so that
+// the per iteration side effects of the cleanup functions can't be folded
+// into a single update after the loop.
+inline void clobber() {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#else
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+int volatile opaque_zero = 0;
+int cleanups             = 0;
+
+void cleanup() noexcept {
+  ++cleanups;
+}
+void close_handle(int handle) noexcept {
+  cleanups += handle;
+}
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+void fail() {
+  throw 42;
+}
+
+// the hand written baselines
+
+struct raii_cleanup {
+  ~raii_cleanup() {
+    cleanup();
+  }
+};
+
+struct raii_handle {
+  int handle;
+  explicit raii_handle(int h) noexcept
+      : handle{h} {}
+  raii_handle(raii_handle &&that) noexcept
+      : handle{std::exchange(that.handle, -1)} {}
+  raii_handle &operator=(raii_handle &&that) noexcept {
+    if (&that != this) {
+      reset();
+      handle = std::exchange(that.handle, -1);
+    }
+    return *this;
+  }
+  ~raii_handle() {
+    reset();
+  }
+  void reset() noexcept {
+    if (handle != -1)
+      close_handle(std::exchange(handle, -1));
+  }
+  void reset(int h) noexcept {
+    reset();
+    handle = h;
+  }
+};
+
+// the gsl::finally pattern
+template <typename F>
+class final_action {
+  F f;
+  bool invoke{true};
+
+public:
+  explicit final_action(F f) noexcept
+      : f{std::move(f)} {}
+  final_action(final_action &&that) noexcept
+      : f{std::move(that.f)}
+      , invoke{std::exchange(that.invoke, false)} {}
+  ~final_action() {
+    if (invoke)
+      f();
+  }
+};
+template <typename F>
+final_action<F> finally(F f) noexcept {
+  return final_action<F>{std::move(f)};
+}
+
+struct deleter {
+  void operator()(int handle) const noexcept {
+    close_handle(handle);
+  }
+};
+using resource = unique_resource<int, deleter>;
+
+// an int the optimizer can't constant fold
+int handle_value() noexcept {
+  return opaque_zero;
+}
+
+// the measured operations, each one is run once per iteration
+
+void raii_exit() {
+  raii_cleanup guard{};
+}
+void gsl_finally_exit() {
+  auto guard = finally([] { cleanup(); });
+}
+void scope_exit_exit() {
+  auto guard = scope_exit([] { cleanup(); });
+}
+void scope_fail_exit() {
+  auto guard = scope_fail([] { cleanup(); });
+}
+void scope_success_exit() {
+  auto guard = scope_success([] { cleanup(); });
+}
+
+void raii_throw() {
+  try {
+    raii_cleanup guard{};
+    fail();
+  } catch (int) {
+  }
+}
+void gsl_finally_throw() {
+  try {
+    auto guard = finally([] { cleanup(); });
+    fail();
+  } catch (int) {
+  }
+}
+void scope_exit_throw() {
+  try {
+    auto guard = scope_exit([] { cleanup(); });
+    fail();
+  } catch (int) {
+  }
+}
+void scope_fail_throw() {
+  try {
+    auto guard = scope_fail([] { cleanup(); });
+    fail();
+  } catch (int) {
+  }
+}
+void scope_success_throw() {
+  try {
+    auto guard = scope_success([] { cleanup(); });
+    fail();
+  } catch (int) {
+  }
+}
+
+// six stacked guards, one per step of work. Every scope_fail/scope_success
+// asks for std::uncaught_exceptions() when it is constructed, guards created
+// through a scope_frame share a single call.
+int steps = 0;
+void step() noexcept {
+  ++steps;
+  clobber();
+}
+
+void six_scope_fail() {
+  step();
+  SCOPE_FAIL([] { cleanup(); });
+  step();
+  SCOPE_FAIL([] { cleanup(); });
+  step();
+  SCOPE_FAIL([] { cleanup(); });
+  step();
+  SCOPE_FAIL([] { cleanup(); });
+  step();
+  SCOPE_FAIL([] { cleanup(); });
+  step();
+  SCOPE_FAIL([] { cleanup(); });
+}
+void six_scope_frame_fail() {
+  scope_frame frame{};
+  step();
+  SCOPE_FRAME_FAIL(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_FAIL(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_FAIL(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_FAIL(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_FAIL(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_FAIL(frame, [] { cleanup(); });
+}
+// the steps can not fail in between, so one group can take the six cleanups
+void six_scope_group_fail() {
+  for (auto i = 0; i < 6; ++i) {
+    step();
+  }
+  SCOPE_GROUP_FAIL([] { cleanup(); }, [] { cleanup(); }, [] { cleanup(); }, [] { cleanup(); }, [] { cleanup(); },
+                   [] { cleanup(); });
+}
+void six_scope_success() {
+  step();
+  SCOPE_SUCCESS([] { cleanup(); });
+  step();
+  SCOPE_SUCCESS([] { cleanup(); });
+  step();
+  SCOPE_SUCCESS([] { cleanup(); });
+  step();
+  SCOPE_SUCCESS([] { cleanup(); });
+  step();
+  SCOPE_SUCCESS([] { cleanup(); });
+  step();
+  SCOPE_SUCCESS([] { cleanup(); });
+}
+void six_scope_frame_success() {
+  scope_frame frame{};
+  step();
+  SCOPE_FRAME_SUCCESS(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_SUCCESS(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_SUCCESS(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_SUCCESS(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_SUCCESS(frame, [] { cleanup(); });
+  step();
+  SCOPE_FRAME_SUCCESS(frame, [] { cleanup(); });
+}
+
+// type erased guards with a capture larger than the small buffer of most
+// std::function implementations
+void function_guard() {
+  int a{}, b{}, c{};
+  auto guard = finally(std::function<void()>{[&a, &b, &c] { cleanup(); }});
+}
+void any_scope_exit_guard() {
+  int a{}, b{}, c{};
+  auto guard = any_scope_exit{[&a, &b, &c] { cleanup(); }};
+}
+void any_scope_exit_moved() {
+  int a{}, b{}, c{};
+  auto guard = any_scope_exit{[&a, &b, &c] { cleanup(); }};
+  auto moved = any_scope_exit{std::move(guard)};
+}
+
+// a run time number of cleanups, the alternative to scope_stack
+void vector_of_function_8() {
+  std::vector<std::function<void()>> cleanups;
+  for (auto i = 0; i < 8; ++i) {
+    cleanups.emplace_back([i] { close_handle(i); });
+  }
+  for (auto it = cleanups.rbegin(); it != cleanups.rend(); ++it) {
+    (*it)();
+  }
+}
+void scope_stack_8() {
+  scope_stack stack;
+  for (auto i = 0; i < 8; ++i) {
+    stack.push([i] { close_handle(i); });
+  }
+}
+void scope_stack_64() {
+  scope_stack stack;
+  for (auto i = 0; i < 64; ++i) {
+    stack.push([i] { close_handle(i); });
+  }
+}
+
+void raii_handle_construct() {
+  raii_handle handle{handle_value()};
+}
+void unique_resource_construct() {
+  resource handle{handle_value(), deleter{}};
+}
+void raii_handle_reset() {
+  raii_handle handle{handle_value()};
+  handle.reset(handle_value() + 1);
+}
+void unique_resource_reset() {
+  resource handle{handle_value(), deleter{}};
+  handle.reset(handle_value() + 1);
+}
+void raii_handle_move_construct() {
+  raii_handle handle{handle_value()};
+  raii_handle other{std::move(handle)};
+}
+void unique_resource_move_construct() {
+  resource handle{handle_value(), deleter{}};
+  resource other{std::move(handle)};
+}
+void raii_handle_move_assign() {
+  raii_handle handle{handle_value()};
+  raii_handle other{handle_value() + 1};
+  other = std::move(handle);
+}
+void unique_resource_move_assign() {
+  resource handle{handle_value(), deleter{}};
+  resource other{handle_value() + 1, deleter{}};
+  other = std::move(handle);
+}
+void raii_handle_checked() {
+  auto const value = handle_value();
+  raii_handle handle{value == -1 ? -1 : value};
+}
+void make_unique_resource_checked_construct() {
+  auto handle = make_unique_resource_checked(handle_value(), -1, deleter{});
+}
+
+// function pointer deleters are called indirectly, function_deleter directly
+void unique_resource_function_pointer() {
+  unique_resource<int, void (*)(int) noexcept> handle{handle_value(), &close_handle};
+}
+void unique_resource_fn_construct() {
+  unique_resource_fn<int, &close_handle> handle{handle_value()};
+}
+
+void raii_handle_throw() {
+  try {
+    raii_handle handle{handle_value()};
+    fail();
+  } catch (int) {
+  }
+}
+void unique_resource_throw() {
+  try {
+    resource handle{handle_value(), deleter{}};
+    fail();
+  } catch (int) {
+  }
+}
+
+// tearing down many handles at once
+constexpr auto many = 1000;
+void unique_resources_1000() {
+  std::vector<resource> handles{};
+  handles.reserve(many);
+  for (auto i = 0; i < many; ++i) {
+    handles.emplace_back(i, deleter{});
+  }
+}
+struct batch_deleter {
+  void operator()(int handle) const noexcept {
+    close_handle(handle);
+  }
+  void operator()(int *first, int *last) const noexcept {
+    for (; first != last; ++first) {
+      close_handle(*first);
+    }
+  }
+};
+void unique_resource_array_1000() {
+  unique_resource_array<int, batch_deleter> handles{};
+  handles.reserve(many);
+  for (auto i = 0; i < many; ++i) {
+    handles.push_back(i);
+  }
+}
+
+// growing from empty, the reallocations move all the handles
+void unique_resources_grow_1000() {
+  std::vector<resource> handles{};
+  for (auto i = 0; i < many; ++i) {
+    handles.emplace_back(i, deleter{});
+  }
+}
+void relocating_vector_grow_1000() {
+  relocating_vector<resource> handles{};
+  for (auto i = 0; i < many; ++i) {
+    handles.emplace_back(i, deleter{});
+  }
+}
+
+// registering handles, looking each up and unregistering them
+void unordered_map_register_1000() {
+  std::unordered_map<std::uint64_t, resource> handles{};
+  std::vector<std::uint64_t> ids{};
+  ids.reserve(many);
+  for (auto i = 0; i < many; ++i) {
+    handles.emplace(static_cast<std::uint64_t>(i), resource(i, deleter{}));
+    ids.push_back(static_cast<std::uint64_t>(i));
+  }
+  for (auto id : ids) {
+    cleanups += handles.find(id)->second.get();
+  }
+  for (auto id : ids) {
+    handles.erase(id);
+  }
+}
+void resource_table_register_1000() {
+  resource_table<int, deleter> handles{};
+  std::vector<resource_table<int, deleter>::handle> ids{};
+  ids.reserve(many);
+  for (auto i = 0; i < many; ++i) {
+    ids.push_back(handles.emplace(i, deleter{}));
+  }
+  for (auto id : ids) {
+    cleanups += handles.find(id)->get();
+  }
+  for (auto id : ids) {
+    handles.erase(id);
+  }
+}
+
+// sharing a handle between two owners
+void shared_ptr_share() {
+  std::shared_ptr<int> first{new int{handle_value()}, [](int *h) {
+                               close_handle(*h);
+                               delete h;
+                             }};
+  auto second = first;
+}
+void shared_resource_share() {
+  shared_resource<int, deleter> first{handle_value(), deleter{}};
+  auto second = first;
+}
+void local_shared_resource_share() {
+  local_shared_resource<int, deleter> first{handle_value(), deleter{}};
+  auto second = first;
+}
+
+constexpr auto repetitions = 5;
+
+template <void (*Run)()>
+double measure(std::size_t iterations) {
+  using clock = std::chrono::steady_clock;
+
+  auto best = clock::duration::max();
+  for (auto repetition = 0; repetition < repetitions; ++repetition) {
+    auto const start = clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+      Run();
+      clobber();
+    }
+    best = std::min(best, clock::now() - start);
+  }
+  return std::chrono::duration<double, std::nano>(best).count() / static_cast<double>(iterations);
+}
+
+struct benchmark {
+  char const *name;
+  double (*measure)(std::size_t iterations);
+  // the exception path and the operations on many handles are orders of
+  // magnitude slower, so they get fewer iterations
+  bool slow;
+};
+
+benchmark const benchmarks[] = {
+    {"raii struct (baseline)", measure<raii_exit>, false},
+    {"gsl::finally (baseline)", measure<gsl_finally_exit>, false},
+    {"scope_exit", measure<scope_exit_exit>, false},
+    {"scope_fail", measure<scope_fail_exit>, false},
+    {"scope_success", measure<scope_success_exit>, false},
+    {"raii struct, throw (baseline)", measure<raii_throw>, true},
+    {"gsl::finally, throw (baseline)", measure<gsl_finally_throw>, true},
+    {"scope_exit, throw", measure<scope_exit_throw>, true},
+    {"scope_fail, throw", measure<scope_fail_throw>, true},
+    {"scope_success, throw", measure<scope_success_throw>, true},
+    {"6 steps with scope_fail", measure<six_scope_fail>, false},
+    {"6 steps with scope_frame::fail", measure<six_scope_frame_fail>, false},
+    {"6 steps with scope_group_fail", measure<six_scope_group_fail>, false},
+    {"6 steps with scope_success", measure<six_scope_success>, false},
+    {"6 steps with scope_frame::success", measure<six_scope_frame_success>, false},
+    {"finally(std::function) (baseline)", measure<function_guard>, false},
+    {"any_scope_exit", measure<any_scope_exit_guard>, false},
+    {"any_scope_exit, moved once", measure<any_scope_exit_moved>, false},
+    {"8 cleanups in a vector<function> (baseline)", measure<vector_of_function_8>, false},
+    {"8 cleanups in a scope_stack", measure<scope_stack_8>, false},
+    {"64 cleanups in a scope_stack", measure<scope_stack_64>, false},
+    {"raii handle construct (baseline)", measure<raii_handle_construct>, false},
+    {"unique_resource construct", measure<unique_resource_construct>, false},
+    {"raii handle reset(r) (baseline)", measure<raii_handle_reset>, false},
+    {"unique_resource reset(r)", measure<unique_resource_reset>, false},
+    {"raii handle move construct (baseline)", measure<raii_handle_move_construct>, false},
+    {"unique_resource move construct", measure<unique_resource_move_construct>, false},
+    {"raii handle move assign (baseline)", measure<raii_handle_move_assign>, false},
+    {"unique_resource move assign", measure<unique_resource_move_assign>, false},
+    {"raii handle checked (baseline)", measure<raii_handle_checked>, false},
+    {"make_unique_resource_checked", measure<make_unique_resource_checked_construct>, false},
+    {"unique_resource, function pointer deleter", measure<unique_resource_function_pointer>, false},
+    {"unique_resource_fn", measure<unique_resource_fn_construct>, false},
+    {"1000 unique_resource in a vector", measure<unique_resources_1000>, true},
+    {"unique_resource_array of 1000", measure<unique_resource_array_1000>, true},
+    {"1000 unique_resource in a growing vector", measure<unique_resources_grow_1000>, true},
+    {"1000 unique_resource in a relocating_vector", measure<relocating_vector_grow_1000>, true},
+    {"1000 unique_resource in an unordered_map by id", measure<unordered_map_register_1000>, true},
+    {"1000 unique_resource in a resource_table", measure<resource_table_register_1000>, true},
+    {"shared_ptr with a deleter, copied (baseline)", measure<shared_ptr_share>, false},
+    {"shared_resource, copied", measure<shared_resource_share>, false},
+    {"local_shared_resource, copied", measure<local_shared_resource_share>, false},
+    {"raii handle, throw (baseline)", measure<raii_handle_throw>, true},
+    {"unique_resource, throw", measure<unique_resource_throw>, true},
+};
+} // namespace
+
+int main(int argc, char **argv) {
+#if SCOPE_BENCH_COUNT_CALLS
+  (void)argc;
+  (void)argv;
+  std::printf("%-46s %14s\n", "benchmark", "uncaught/op");
+  for (auto const &bench : benchmarks) {
+    auto const calls = uncaught_exceptions_calls;
+    bench.measure(1);
+    std::printf("%-46s %14lld\n", bench.name, (uncaught_exceptions_calls - calls) / repetitions);
+  }
+#else
+  std::size_t const iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+  std::printf("%-46s %10s\n", "benchmark", "ns/op");
+  for (auto const &bench : benchmarks) {
+    auto const n = bench.slow ? std::max<std::size_t>(iterations / 1000, 1) : iterations;
+    std::printf("%-46s %10.3f\n", bench.name, bench.measure(n));
+  }
+#endif
+  return cleanups + steps == 0; // keep the side effects observable
+}
@@ -0,0 +1,59 @@
+#include "scope.hpp"
+
+#include <utility>
+
+// A compile time benchmark: instantiates SCOPE_COMPILE_BENCH_N distinct
+// guards and resources, so the time to compile this file measures the
+// front end cost of the header. Build the targets compile_bench_cxx17 and
+// compile_bench_cxx20 and compare, e.g. with -ftime-report.
+
+#ifndef SCOPE_COMPILE_BENCH_N
+#define SCOPE_COMPILE_BENCH_N 200
+#endif
+
+namespace {
+int volatile sink = 0;
+
+template <int I>
+struct deleter {
+  void operator()(int r) const noexcept {
+    sink = r + I;
+  }
+};
+
+template <int I>
+struct pointer_deleter {
+  void operator()(int *r) const noexcept {
+    sink = *r + I;
+  }
+};
+
+template <int I>
+void close(int r) noexcept {
+  sink = r - I;
+}
+
+template <int I>
+void instantiate() {
+  int value = I;
+  scope::scope_exit exit{[] { sink = I; }};
+  scope::scope_fail fail{[&value] { sink = value; }};
+  scope::scope_success success{[] { sink = -I; }};
+  scope::unique_resource resource{I, deleter<I>{}};
+  scope::unique_resource_fn<int, &close<I>> fn{I};
+  scope::unique_resource pointer{&value, pointer_deleter<I>{}};
+  auto checked = scope::make_unique_resource_checked(I, -1, deleter<I>{});
+  sink         = *pointer + resource.get() + fn.get() + checked.get();
+  if (sink == I)
+    exit.release();
+}
+
+template <int... I>
+void instantiate_all(std::integer_sequence<int, I...>) {
+  (instantiate<I>(), ...);
+}
+} // namespace
+
+int main() {
+  instantiate_all(std::make_integer_sequence<int, SCOPE_COMPILE_BENCH_N>{});
+}
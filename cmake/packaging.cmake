@@ -17,7 +17,7 @@ export(
   FILE scopeTargets.cmake
   )
 
-install(FILES include/scope.hpp DESTINATION include)
+install(DIRECTORY include/ DESTINATION include FILES_MATCHING PATTERN "*.hpp")
 
 include(CMakePackageConfigHelpers)
 configure_package_config_file(scopeConfig.cmake.in
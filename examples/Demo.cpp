@@ -5,8 +5,11 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "scope.hpp"
+#include "scope_stack.hpp"
 
 #include <fcntl.h>
 
@@ -42,6 +45,41 @@ void DemonstrateTransactionFilecopy() {
     assert(exists(to) == true);
 }
 
+// all or nothing: a failing copy removes the copies made before it
+void copy_files_transact(std::vector<std::pair<path, path>> const &copies) {
+    scope_transaction tx;
+    for (auto const &[from, to] : copies) {
+        copy_file(from, to);
+        tx.on_rollback([&to] { remove(to); });
+    }
+    tx.commit();
+}
+
+void DemonstrateTransactionMultiFilecopy() {
+    std::string name("hello.txt");
+    {
+        std::ofstream ofs{name};
+        ofs << "Hello world\n";
+    }
+
+    try {
+        copy_files_transact({{name, "scope_hello1.txt"},
+                             {name, "scope_hello2.txt"},
+                             {"doesnotexist.txt", "scope_hello3.txt"}});
+    } catch (std::filesystem::filesystem_error const &) {
+    }
+    assert(!exists(path{"scope_hello1.txt"}));
+    assert(!exists(path{"scope_hello2.txt"}));
+
+    copy_files_transact({{name, "scope_hello1.txt"}, {name, "scope_hello2.txt"}});
+    auto guard = scope_success{[] {
+        remove(path{"scope_hello1.txt"});
+        remove(path{"scope_hello2.txt"});
+    }};
+    assert(exists(path{"scope_hello1.txt"}));
+    assert(exists(path{"scope_hello2.txt"}));
+}
+
 void demonstrate_unique_resource_with_stdio() {
     const std::string filename = "hello.txt";
     auto fclose = [](auto file) {
@@ -113,6 +151,7 @@ void demo_scope_exit_fail_success() {
 
 int main() {
     DemonstrateTransactionFilecopy();
+    DemonstrateTransactionMultiFilecopy();
     demonstrate_unique_resource_with_stdio();
     demontrate_unique_resource_with_POSIX_IO();
     demo_scope_exit_fail_success();
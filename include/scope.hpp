@@ -7,24 +7,157 @@
 //          https://www.boost.org/LICENSE_1_0.txt)
 
 #include <exception> // for std::uncaught_exceptions
-#include <functional>
-#include <limits> // for maxint
+#include <limits>    // for maxint
 #include <type_traits>
 #include <utility>
 
+#if defined(_MSC_VER) && _MSC_VER >= 1929
+#define SCOPE_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#elif defined(__has_cpp_attribute)
+#if __has_cpp_attribute(no_unique_address)
+#define SCOPE_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+#endif
+#ifndef SCOPE_NO_UNIQUE_ADDRESS
+#define SCOPE_NO_UNIQUE_ADDRESS
+#endif
+
+// Define SCOPE_NO_EXCEPTIONS to 1 to compile without exception support, it is
+// the default when exceptions are disabled, e.g. with -fno-exceptions. Scopes
+// can not be left by an exception then, so scope_fail never executes and
+// scope_success always does, without calling std::uncaught_exceptions(), and
+// the library does not catch exceptions.
+#ifndef SCOPE_NO_EXCEPTIONS
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define SCOPE_NO_EXCEPTIONS 0
+#else
+#define SCOPE_NO_EXCEPTIONS 1
+#endif
+#endif
+#if SCOPE_NO_EXCEPTIONS
+#define SCOPE_TRY if (true)
+#define SCOPE_CATCH_ALL if (false)
+#define SCOPE_RETHROW
+#else
+#define SCOPE_TRY try
+#define SCOPE_CATCH_ALL catch (...)
+#define SCOPE_RETHROW throw
+#endif
+
+// The call the guards make to learn the number of uncaught exceptions. It can
+// be defined before scope.hpp is included to wrap std::uncaught_exceptions(),
+// e.g. to count the calls.
+#ifndef SCOPE_UNCAUGHT_EXCEPTIONS
+#define SCOPE_UNCAUGHT_EXCEPTIONS() std::uncaught_exceptions()
+#endif
+
+// With C++20, the constructors are constrained with concepts instead of
+// enable_if, which takes the compiler less work. Define SCOPE_CONCEPTS to 0 to
+// use the C++17 path anyway.
+#ifndef SCOPE_CONCEPTS
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#define SCOPE_CONCEPTS 1
+#else
+#define SCOPE_CONCEPTS 0
+#endif
+#endif
+
+// Define SCOPE_INSTRUMENTATION to 1 to make basic_scope_exit and
+// unique_resource report their lifecycle events to the sink installed with
+// scope::set_scope_sink(). When it is 0, the default, no code is generated for
+// it.
+#ifndef SCOPE_INSTRUMENTATION
+#define SCOPE_INSTRUMENTATION 0
+#endif
+#if SCOPE_INSTRUMENTATION
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+// the acquisition site of a unique_resource, as a trailing parameter
+#define SCOPE_WHERE_PARAM , scope::scope_location where = scope::scope_location::current()
+#define SCOPE_WHERE_ARG , where
+#else
+#define SCOPE_WHERE_PARAM
+#define SCOPE_WHERE_ARG
+#endif
+
 #define SCOPE_CONCAT_IMPL(a, b) a##b
 #define SCOPE_CONCAT(a, b) SCOPE_CONCAT_IMPL(a, b)
 #ifdef __COUNTER__
 #define SCOPE_EXIT(...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_exit(__VA_ARGS__)
 #define SCOPE_FAIL(...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_fail(__VA_ARGS__)
 #define SCOPE_SUCCESS(...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_success(__VA_ARGS__)
+#define SCOPE_GROUP_EXIT(...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_group_exit(__VA_ARGS__)
+#define SCOPE_GROUP_FAIL(...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_group_fail(__VA_ARGS__)
+#define SCOPE_GROUP_SUCCESS(...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_group_success(__VA_ARGS__)
+#define SCOPE_FRAME_FAIL(frame, ...) auto SCOPE_CONCAT(scope_, __COUNTER__) = (frame).fail(__VA_ARGS__)
+#define SCOPE_FRAME_SUCCESS(frame, ...) auto SCOPE_CONCAT(scope_, __COUNTER__) = (frame).success(__VA_ARGS__)
+#define SCOPE_FAIL_ON(status, ...) auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_fail_on(status, __VA_ARGS__)
+#define SCOPE_SUCCESS_ON(status, ...)                                                                                  \
+  auto SCOPE_CONCAT(scope_, __COUNTER__) = scope::scope_success_on(status, __VA_ARGS__)
 #else
 #define SCOPE_EXIT(...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_exit(__VA_ARGS__)
 #define SCOPE_FAIL(...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_fail(__VA_ARGS__)
 #define SCOPE_SUCCESS(...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_success(__VA_ARGS__)
+#define SCOPE_GROUP_EXIT(...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_group_exit(__VA_ARGS__)
+#define SCOPE_GROUP_FAIL(...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_group_fail(__VA_ARGS__)
+#define SCOPE_GROUP_SUCCESS(...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_group_success(__VA_ARGS__)
+#define SCOPE_FRAME_FAIL(frame, ...) auto SCOPE_CONCAT(scope_, __LINE__) = (frame).fail(__VA_ARGS__)
+#define SCOPE_FRAME_SUCCESS(frame, ...) auto SCOPE_CONCAT(scope_, __LINE__) = (frame).success(__VA_ARGS__)
+#define SCOPE_FAIL_ON(status, ...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_fail_on(status, __VA_ARGS__)
+#define SCOPE_SUCCESS_ON(status, ...) auto SCOPE_CONCAT(scope_, __LINE__) = scope::scope_success_on(status, __VA_ARGS__)
 #endif
 
 namespace scope {
+
+// Customization point for unique_resource<R, D>. A specialization providing
+//
+//   static constexpr R invalid() noexcept;
+//
+// makes unique_resource<R, D> mark that it does not own a resource by holding
+// that value instead of keeping an extra flag. The consequences are that
+// a unique_resource constructed with, reset to, or moved from that value owns
+// nothing, and that get() returns it after release() or reset().
+template <typename R, typename D>
+struct resource_traits {};
+
+// Customization point for scope_fail_on and scope_success_on, which decide
+// whether to execute from a status instead of an exception. By default, a
+// status S has failed if
+//   - it is false, for bool,
+//   - !s.has_value(), for expected like types,
+//   - static_cast<bool>(s) otherwise, e.g. for std::error_code.
+template <typename S, typename = void>
+struct status_traits {
+  static bool failed(S const &s) noexcept {
+    return static_cast<bool>(s);
+  }
+};
+template <>
+struct status_traits<bool> {
+  static bool failed(bool s) noexcept {
+    return !s;
+  }
+};
+template <typename S>
+struct status_traits<S, std::void_t<decltype(std::declval<S const &>().has_value())>> {
+  static bool failed(S const &s) noexcept {
+    return !s.has_value();
+  }
+};
+
+// Customization point telling whether moving a T to a new address and
+// destroying the original can be done by copying its bytes instead, which
+// relocating_vector in scope_relocate.hpp does when it grows. It holds for
+// trivially copyable types, and for unique_resource and the guards whose
+// members are trivially relocatable. Specialize it as true for other types
+// that do not depend on their own address, e.g. a handle class with a user
+// provided move constructor.
+template <typename T, typename = void>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 namespace detail {
 namespace hidden {
 
@@ -44,14 +177,19 @@ constexpr typename std::
 } // namespace hidden
 template <typename T>
 class _box {
-  T value;
+  SCOPE_NO_UNIQUE_ADDRESS T value;
   explicit _box(T const &t) noexcept(noexcept(T(t)))
       : value(t) {}
   explicit _box(T &&t) noexcept(noexcept(T(std::move_if_noexcept(t))))
       : value(std::move_if_noexcept(t)) {}
 
 public:
+#if SCOPE_CONCEPTS
+  template <typename TT, typename GG>
+    requires std::is_constructible_v<T, TT>
+#else
   template <typename TT, typename GG, typename = std::enable_if_t<std::is_constructible_v<T, TT>>>
+#endif
   //	    explicit _box(TT &&t, GG &&guard) noexcept(noexcept(_box((T &&) t)))
   explicit _box(TT &&t, GG &&guard) noexcept(noexcept(_box(std::declval<TT>())))
       : _box(std::forward<TT>(t)) {
@@ -76,25 +214,49 @@ public:
 
 template <typename T>
 class _box<T &> {
-  std::reference_wrapper<T> value;
+  T *value;
 
 public:
+#if SCOPE_CONCEPTS
+  template <typename TT, typename GG>
+    requires std::is_convertible_v<TT, T &>
+#else
   template <typename TT, typename GG, typename = std::enable_if_t<std::is_convertible_v<TT, T &>>>
+#endif
   _box(TT &&t, GG &&guard) noexcept(noexcept(static_cast<T &>(static_cast<TT &&>(t))))
-      : value(static_cast<T &>(t)) {
+      : value(&static_cast<T &>(t)) {
     guard.release();
   }
   T &get() const noexcept {
-    return value.get();
+    return *value;
   }
   T &move() const noexcept {
     return get();
   }
   void reset(T &t) noexcept {
-    value = std::ref(t);
+    value = &t;
   }
 };
 
+// What to construct an EF from while a failsafe may still invoke ef: ef as
+// an lvalue, so that it is copied and left intact, if constructing from EFP
+// could throw, ef as EFP otherwise, as _box does with move_if_noexcept.
+template <class EF, class EFP>
+using _keep_if_throwing_t =
+    std::conditional_t<!std::is_nothrow_constructible_v<EF, EFP> && std::is_constructible_v<EF, EFP &>, EFP &, EFP &&>;
+template <class EF, class EFP>
+constexpr _keep_if_throwing_t<EF, EFP> _forward_keeping(EFP &ef) noexcept {
+  return static_cast<_keep_if_throwing_t<EF, EFP>>(ef);
+}
+
+inline int _uncaught_exceptions() noexcept {
+#if SCOPE_NO_EXCEPTIONS
+  return 0;
+#else
+  return SCOPE_UNCAUGHT_EXCEPTIONS();
+#endif
+}
+
 // new policy-based exception proof design by Eric Niebler
 
 struct on_exit_policy {
@@ -110,29 +272,215 @@ struct on_exit_policy {
 };
 
 struct on_fail_policy {
-  int ec_{std::uncaught_exceptions()};
+  int ec_{_uncaught_exceptions()};
 
   void release() noexcept {
     ec_ = std::numeric_limits<int>::max();
   }
 
   bool should_execute() const noexcept {
-    return ec_ < std::uncaught_exceptions();
+    return ec_ < _uncaught_exceptions();
   }
 };
 
 struct on_success_policy {
-  int ec_{std::uncaught_exceptions()};
+  int ec_{_uncaught_exceptions()};
 
   void release() noexcept {
     ec_ = -1;
   }
 
   bool should_execute() const noexcept {
-    return ec_ >= std::uncaught_exceptions();
+    return ec_ >= _uncaught_exceptions();
+  }
+};
+
+// decide from the status bound to the guard when it is destroyed
+template <typename S>
+struct on_status_fail_policy {
+  S const *status_;
+  bool execute_{true};
+
+  void release() noexcept {
+    execute_ = false;
+  }
+
+  bool should_execute() const noexcept {
+    return execute_ && status_traits<S>::failed(*status_);
+  }
+};
+
+template <typename S>
+struct on_status_success_policy {
+  S const *status_;
+  bool execute_{true};
+
+  void release() noexcept {
+    execute_ = false;
+  }
+
+  bool should_execute() const noexcept {
+    return execute_ && !status_traits<S>::failed(*status_);
   }
 };
+
+// Policy for the guards the library uses itself, e.g. the failsafes, which
+// are not reported to the instrumentation sink.
+template <class Policy>
+struct _quiet : Policy {
+  _quiet() = default;
+  explicit _quiet(Policy const &policy) noexcept
+      : Policy(policy) {}
+};
+
+template <class Policy>
+inline constexpr bool _reports_v = true;
+template <class Policy>
+inline constexpr bool _reports_v<_quiet<Policy>> = false;
 } // namespace detail
+
+#if SCOPE_INSTRUMENTATION
+template <typename R, typename D>
+class unique_resource;
+
+enum class scope_event : unsigned char {
+  constructed,
+  released,
+  executed_on_exit,
+  executed_on_fail,
+  executed_on_success,
+  reset,   // unique_resource::reset(r)
+  deleted, // a unique_resource called its deleter
+};
+inline constexpr std::size_t scope_event_count = 7;
+
+// Where events come from: the type of a guard's exit function, which is
+// distinct for each lambda and hence for each SCOPE_EXIT, or the type of a
+// unique_resource.
+struct scope_site {
+  char const *name;
+  // a dense number for the site, 1 for the first one reporting an event
+  std::atomic<std::size_t> index{0};
+};
+
+// The source location a unique_resource acquired its resource at.
+struct scope_location {
+  char const *file;
+  unsigned line;
+
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+  static constexpr scope_location current(char const *file = __builtin_FILE(),
+                                          unsigned line    = __builtin_LINE()) noexcept {
+    return {file, line};
+  }
+#else
+  static constexpr scope_location current() noexcept {
+    return {nullptr, 0};
+  }
+#endif
+};
+
+enum class scope_kind : unsigned char { guard, resource };
+
+struct scope_record {
+  scope_event event;
+  scope_kind kind;
+  scope_site *site;
+  void const *object;
+  // the resource of a unique_resource if it is an integer or a pointer
+  std::uintptr_t handle;
+  // the time taken by the exit function or deleter for executed_* and deleted
+  std::uint64_t nanoseconds;
+  // for constructed and reset events of a unique_resource
+  scope_location where;
+};
+
+using scope_sink = void (*)(scope_record const &) noexcept;
+
+namespace detail {
+inline std::atomic<scope_sink> _scope_sink{nullptr};
+inline std::atomic<std::size_t> _scope_sites{0};
+
+template <typename T>
+constexpr char const *_type_name() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return __FUNCSIG__;
+#else
+  return __PRETTY_FUNCTION__;
+#endif
+}
+template <typename T>
+inline scope_site _site_of{_type_name<T>()};
+
+template <typename Policy>
+inline constexpr scope_event _executed_event = scope_event::executed_on_exit;
+template <>
+inline constexpr scope_event _executed_event<on_fail_policy> = scope_event::executed_on_fail;
+template <>
+inline constexpr scope_event _executed_event<on_success_policy> = scope_event::executed_on_success;
+template <typename S>
+inline constexpr scope_event _executed_event<on_status_fail_policy<S>> = scope_event::executed_on_fail;
+template <typename S>
+inline constexpr scope_event _executed_event<on_status_success_policy<S>> = scope_event::executed_on_success;
+
+template <typename R>
+std::uintptr_t _handle_of(R const &r) noexcept {
+  if constexpr (std::is_pointer_v<R>)
+    return reinterpret_cast<std::uintptr_t>(r);
+  else if constexpr (std::is_integral_v<R> || std::is_enum_v<R>)
+    return static_cast<std::uintptr_t>(r);
+  else
+    return 0;
+}
+
+template <typename T>
+inline constexpr scope_kind _kind_of = scope_kind::guard;
+template <typename R, typename D>
+inline constexpr scope_kind _kind_of<unique_resource<R, D>> = scope_kind::resource;
+
+template <typename T>
+void _notify(scope_event event, void const *object, std::uintptr_t handle = 0, scope_location where = {}) noexcept {
+  if (auto const sink = _scope_sink.load(std::memory_order_acquire))
+    sink(scope_record{event, _kind_of<T>, &_site_of<T>, object, handle, 0, where});
+}
+// invokes f and reports how long it took
+template <typename T, typename F>
+void _notify_timed(scope_event event, void const *object, std::uintptr_t handle, F &&f) {
+  auto const sink = _scope_sink.load(std::memory_order_acquire);
+  if (!sink) {
+    f();
+    return;
+  }
+  auto const start = std::chrono::steady_clock::now();
+  f();
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+  sink(scope_record{event,
+                    _kind_of<T>,
+                    &_site_of<T>,
+                    object,
+                    handle,
+                    static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                    {}});
+}
+} // namespace detail
+
+// Installs the sink receiving the events, nullptr stops reporting. The sink
+// is called on the thread the event happens on and must be thread safe.
+inline scope_sink set_scope_sink(scope_sink sink) noexcept {
+  return detail::_scope_sink.exchange(sink, std::memory_order_acq_rel);
+}
+
+inline std::size_t scope_site_index(scope_site &site) noexcept {
+  auto index = site.index.load(std::memory_order_acquire);
+  if (index == 0) {
+    auto const fresh = detail::_scope_sites.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (site.index.compare_exchange_strong(index, fresh, std::memory_order_acq_rel))
+      index = fresh;
+  }
+  return index;
+}
+#endif
+
 template <class EF, class Policy = detail::on_exit_policy>
 class basic_scope_exit; // silence brain dead clang warning -Wmismatched-tags
 
@@ -172,16 +520,113 @@ struct scope_success : basic_scope_exit<EF, detail::on_success_policy> {
 template <class EF>
 scope_success(EF) -> scope_success<EF>;
 
+// Guards that execute depending on a status bound to them, which they check
+// when they are destroyed, instead of on an exception. They need no
+// std::uncaught_exceptions() call and work without exception support.
+//
+//   std::error_code ec;
+//   scope::scope_fail_on rollback{ec, [&] { tx.rollback(); }};
+//   tx.write(data, ec);
+template <class S, class EF>
+struct [[nodiscard]] scope_fail_on : basic_scope_exit<EF, detail::on_status_fail_policy<S>> {
+  template <typename EFP>
+  scope_fail_on(S const &status, EFP &&ef) noexcept(
+      std::is_nothrow_constructible_v<basic_scope_exit<EF, detail::on_status_fail_policy<S>>,
+                                      EFP,
+                                      detail::on_status_fail_policy<S> const &>)
+      : basic_scope_exit<EF, detail::on_status_fail_policy<S>>(std::forward<EFP>(ef),
+                                                                detail::on_status_fail_policy<S>{&status}) {}
+  // the status has to outlive the guard
+  template <typename EFP>
+  scope_fail_on(S const &&, EFP &&) = delete;
+};
+
+template <class S, class EF>
+scope_fail_on(S const &, EF) -> scope_fail_on<S, EF>;
+
+template <class S, class EF>
+struct [[nodiscard]] scope_success_on : basic_scope_exit<EF, detail::on_status_success_policy<S>> {
+  template <typename EFP>
+  scope_success_on(S const &status, EFP &&ef) noexcept(
+      std::is_nothrow_constructible_v<basic_scope_exit<EF, detail::on_status_success_policy<S>>,
+                                      EFP,
+                                      detail::on_status_success_policy<S> const &>)
+      : basic_scope_exit<EF, detail::on_status_success_policy<S>>(std::forward<EFP>(ef),
+                                                                   detail::on_status_success_policy<S>{&status}) {}
+  template <typename EFP>
+  scope_success_on(S const &&, EFP &&) = delete;
+};
+
+template <class S, class EF>
+scope_success_on(S const &, EF) -> scope_success_on<S, EF>;
+
 namespace detail {
 // DETAIL:
 template <class Policy, class EF>
 auto _make_guard(EF &&ef) {
   return basic_scope_exit<std::decay_t<EF>, Policy>(std::forward<EF>(ef));
 }
+template <class EF>
+auto _quiet_exit(EF &&ef) {
+  return _make_guard<_quiet<on_exit_policy>>(std::forward<EF>(ef));
+}
+template <class EF>
+auto _quiet_fail(EF &&ef) {
+  return _make_guard<_quiet<on_fail_policy>>(std::forward<EF>(ef));
+}
 struct _empty_scope_exit {
   void release() const noexcept {}
 };
 
+#if SCOPE_CONCEPTS
+template <typename T, typename U>
+concept _box_constructible = std::is_constructible_v<_box<T>, U, _empty_scope_exit>;
+#endif
+
+// whether a unique_resource has to call its deleter, kept in a bool
+template <typename R, typename D, typename = void>
+class _ownership {
+  bool execute_on_destruction_;
+
+public:
+  static constexpr bool uses_sentinel = false;
+
+  explicit _ownership(bool owns) noexcept
+      : execute_on_destruction_{owns} {}
+  bool owns(_box<R> const &) const noexcept {
+    return execute_on_destruction_;
+  }
+  void own(_box<R> &) noexcept {
+    execute_on_destruction_ = true;
+  }
+  void disown(_box<R> &) noexcept {
+    execute_on_destruction_ = false;
+  }
+};
+
+// ... or encoded as resource_traits<R, D>::invalid() in the resource itself
+template <typename R, typename D>
+class _ownership<R, D, std::enable_if_t<!std::is_reference_v<R>, decltype(void(resource_traits<R, D>::invalid()))>> {
+  static_assert(std::is_nothrow_copy_assignable_v<R>,
+                "a resource with an invalid value must be nothrow copy assignable");
+
+  static bool _is_invalid(R const &r) noexcept {
+    return r == resource_traits<R, D>::invalid();
+  }
+
+public:
+  static constexpr bool uses_sentinel = true;
+
+  explicit _ownership(bool) noexcept {}
+  bool owns(_box<R> const &r) const noexcept {
+    return !_is_invalid(r.get());
+  }
+  void own(_box<R> &) noexcept {}
+  void disown(_box<R> &r) noexcept {
+    r.reset(resource_traits<R, D>::invalid());
+  }
+};
+
 } // namespace detail
 
 // Requires: EF is Callable
@@ -192,22 +637,25 @@ class [[nodiscard]] basic_scope_exit : Policy {
   static_assert(std::is_nothrow_move_constructible_v<EF> || std::is_copy_constructible_v<EF>,
                 "scope guard function must be nothrow move constructible or "
                 "copy constructible");
-  detail::_box<EF> exit_function;
+  SCOPE_NO_UNIQUE_ADDRESS detail::_box<EF> exit_function;
   // lambdas can degenerate to object pointers
-  static auto _make_failsafe(std::true_type, const void *) {
+  static auto _make_failsafe(std::true_type, const void *, Policy const &) {
     return detail::_empty_scope_exit{};
   }
   // function pointers (from reference) can not degenerate to an object
   // pointer
-  static auto _make_failsafe(std::true_type, void (*)()) {
+  static auto _make_failsafe(std::true_type, void (*)(), Policy const &) {
     return detail::_empty_scope_exit{};
   }
+  // the failsafe shares the policy state of the guard being constructed
   template <typename Fn>
-  static auto _make_failsafe(std::false_type, Fn *fn) {
-    return basic_scope_exit<Fn &, Policy>(*fn);
+  static auto _make_failsafe(std::false_type, Fn *fn, Policy const &policy) {
+    return basic_scope_exit<Fn &, detail::_quiet<Policy>>(*fn, detail::_quiet<Policy>(policy));
   }
+#if !SCOPE_CONCEPTS
   template <typename EFP>
   using _ctor_from = std::is_constructible<detail::_box<EF>, EFP, detail::_empty_scope_exit>;
+#endif
   template <typename EFP>
 #ifndef _MSC_VER
   using _noexcept_ctor_from =
@@ -218,27 +666,249 @@ class [[nodiscard]] basic_scope_exit : Policy {
       std::bool_constant<noexcept(detail::_box<EF>::_box(std::declval<EFP>(), detail::_empty_scope_exit{}))>;
 #endif
 public:
+#if SCOPE_CONCEPTS
+  template <typename EFP>
+    requires detail::_box_constructible<EF, EFP>
+#else
   template <typename EFP, typename = std::enable_if_t<_ctor_from<EFP>::value>>
+#endif
   explicit basic_scope_exit(EFP &&ef) noexcept(_noexcept_ctor_from<EFP>::value)
-      : exit_function(std::forward<EFP>(ef), _make_failsafe(_noexcept_ctor_from<EFP>{}, &ef)) {}
-  basic_scope_exit(basic_scope_exit &&that) noexcept(noexcept(detail::_box<EF>(that.exit_function.move(), that)))
+      : exit_function(std::forward<EFP>(ef), _make_failsafe(_noexcept_ctor_from<EFP>{}, &ef, *this)) {
+#if SCOPE_INSTRUMENTATION
+    if constexpr (detail::_reports_v<Policy>)
+      detail::_notify<EF>(scope_event::constructed, this);
+#endif
+  }
+  // starts from an already initialized policy, e.g. one handed out by a scope_frame
+#if SCOPE_CONCEPTS
+  template <typename EFP>
+    requires detail::_box_constructible<EF, EFP>
+#else
+  template <typename EFP, typename = std::enable_if_t<_ctor_from<EFP>::value>>
+#endif
+  basic_scope_exit(EFP &&ef, Policy const &policy) noexcept(_noexcept_ctor_from<EFP>::value)
+      : Policy(policy)
+      , exit_function(std::forward<EFP>(ef), _make_failsafe(_noexcept_ctor_from<EFP>{}, &ef, *this)) {
+#if SCOPE_INSTRUMENTATION
+    if constexpr (detail::_reports_v<Policy>)
+      detail::_notify<EF>(scope_event::constructed, this);
+#endif
+  }
+  // the moved from guard is released through its policy, which is not
+  // reported as a release
+  basic_scope_exit(basic_scope_exit &&that) noexcept(
+      noexcept(detail::_box<EF>(that.exit_function.move(), static_cast<Policy &>(that))))
       : Policy(that)
-      , exit_function(that.exit_function.move(), that) {}
+      , exit_function(that.exit_function.move(), static_cast<Policy &>(that)) {}
   ~basic_scope_exit() noexcept(noexcept(exit_function.get()())) {
-    if (this->should_execute())
+    if (this->should_execute()) {
+#if SCOPE_INSTRUMENTATION
+      if constexpr (detail::_reports_v<Policy>) {
+        detail::_notify_timed<EF>(detail::_executed_event<Policy>, this, 0, exit_function.get());
+        return;
+      }
+#endif
       exit_function.get()();
+    }
   }
   // implicitly deleted or not defined
   //	basic_scope_exit(const basic_scope_exit &) = delete;
   //	basic_scope_exit &operator=(const basic_scope_exit &) = delete;
   //    basic_scope_exit &operator=(basic_scope_exit &&) = delete;
 
+#if SCOPE_INSTRUMENTATION
+  void release() noexcept {
+    Policy::release();
+    if constexpr (detail::_reports_v<Policy>)
+      detail::_notify<EF>(scope_event::released, this);
+  }
+#else
   using Policy::release;
+#endif
 };
 
 template <class EF, class Policy>
 void swap(basic_scope_exit<EF, Policy> &, basic_scope_exit<EF, Policy> &) = delete;
 
+namespace detail {
+template <std::size_t I, class EF>
+struct _group_element {
+  SCOPE_NO_UNIQUE_ADDRESS EF fn;
+};
+
+template <std::size_t I, class EF>
+EF &_group_at(_group_element<I, EF> &e) noexcept {
+  return e.fn;
+}
+
+// the last one first, f is still invoked if one of the others throws, as the
+// earlier of separate guards are
+inline void _invoke_reversed() noexcept {}
+template <class F, class... Rest>
+void _invoke_reversed(F &f, Rest &...rest) {
+  if constexpr ((std::is_nothrow_invocable_v<Rest &> && ...)) {
+    _invoke_reversed(rest...);
+    f();
+  } else {
+    auto guard = _quiet_exit([&f] { f(); });
+    _invoke_reversed(rest...);
+  }
+}
+
+// the exit functions of a group, in one object without std::tuple
+template <class Indices, class... EF>
+struct _group;
+template <std::size_t... I, class... EF>
+struct _group<std::index_sequence<I...>, EF...> : _group_element<I, EF>... {
+  static constexpr bool nothrow_invocable_v = (std::is_nothrow_invocable_v<EF &> && ...);
+
+  template <class GG, class... EFP>
+  explicit _group(GG &&guard, EFP &&...ef)
+      : _group_element<I, EF>{std::forward<EFP>(ef)}... {
+    guard.release();
+  }
+  void operator()() noexcept(nothrow_invocable_v) {
+    _invoke_reversed(_group_at<I>(*this)...);
+  }
+};
+} // namespace detail
+
+// Executes several exit functions from one guard, in reverse order, as the
+// same number of guards declared one after the other would. The policy is
+// evaluated once for all of them and there is a single object on the stack.
+// If one of them throws, the ones before it are still executed while the
+// exception propagates, as their guards would be.
+//
+//   SCOPE_GROUP_FAIL([&] { undo_first(); }, [&] { undo_second(); });
+//
+// If copying one of the exit functions throws, they are all executed before
+// the exception propagates, as a guard does with its exit function. To keep
+// them intact for that, they are all copied then, not moved, unless they are
+// move only.
+template <class Policy, class... EF>
+class [[nodiscard]] basic_scope_group : Policy {
+  static_assert(sizeof...(EF) > 0, "a scope group needs exit functions");
+  static_assert((std::is_invocable_v<EF &> && ...), "scope guard must be callable");
+  static_assert(((std::is_nothrow_move_constructible_v<EF> || std::is_copy_constructible_v<EF>) && ...),
+                "scope guard function must be nothrow move constructible or "
+                "copy constructible");
+  using group = detail::_group<std::index_sequence_for<EF...>, EF...>;
+
+  SCOPE_NO_UNIQUE_ADDRESS group exit_functions;
+
+  template <class... EFP>
+  using _nothrow_ctor_from = std::bool_constant<(std::is_nothrow_constructible_v<EF, EFP> && ...)>;
+
+  template <class... EFP>
+  static auto _make_failsafe(std::true_type, Policy const &, EFP &...) {
+    return detail::_empty_scope_exit{};
+  }
+  template <class... EFP>
+  static auto _make_failsafe(std::false_type, Policy const &policy, EFP &...ef) {
+    auto invoke = [&ef...] { detail::_invoke_reversed(ef...); };
+    return basic_scope_exit<decltype(invoke), detail::_quiet<Policy>>(invoke, detail::_quiet<Policy>(policy));
+  }
+  // while the failsafe is armed it may execute the originals, so they are
+  // copied, only those that can't be copied are moved
+  template <class E, class EFP>
+  static EFP &&_pass(std::true_type, EFP &ef) noexcept {
+    return static_cast<EFP &&>(ef);
+  }
+  template <class E, class EFP>
+  static std::conditional_t<std::is_constructible_v<E, EFP &>, EFP &, EFP &&> _pass(std::false_type,
+                                                                                   EFP &ef) noexcept {
+    return static_cast<std::conditional_t<std::is_constructible_v<E, EFP &>, EFP &, EFP &&>>(ef);
+  }
+
+public:
+#if SCOPE_CONCEPTS
+  template <class... EFP>
+    requires(sizeof...(EFP) == sizeof...(EF) && (std::is_constructible_v<EF, EFP> && ...))
+#else
+  template <class... EFP,
+            typename = std::enable_if_t<sizeof...(EFP) == sizeof...(EF) && (std::is_constructible_v<EF, EFP> && ...)>>
+#endif
+  explicit basic_scope_group(EFP &&...ef) noexcept(_nothrow_ctor_from<EFP...>::value)
+      : exit_functions(_make_failsafe(_nothrow_ctor_from<EFP...>{}, *this, ef...),
+                       _pass<EF, EFP>(_nothrow_ctor_from<EFP...>{}, ef)...) {
+#if SCOPE_INSTRUMENTATION
+    if constexpr (detail::_reports_v<Policy>)
+      detail::_notify<group>(scope_event::constructed, this);
+#endif
+  }
+  basic_scope_group(basic_scope_group const &) = delete;
+  basic_scope_group &operator=(basic_scope_group const &) = delete;
+  ~basic_scope_group() noexcept(group::nothrow_invocable_v) {
+    if (this->should_execute()) {
+#if SCOPE_INSTRUMENTATION
+      if constexpr (detail::_reports_v<Policy>) {
+        detail::_notify_timed<group>(detail::_executed_event<Policy>, this, 0, exit_functions);
+        return;
+      }
+#endif
+      exit_functions();
+    }
+  }
+
+#if SCOPE_INSTRUMENTATION
+  void release() noexcept {
+    Policy::release();
+    if constexpr (detail::_reports_v<Policy>)
+      detail::_notify<group>(scope_event::released, this);
+  }
+#else
+  using Policy::release;
+#endif
+};
+
+template <class... EF>
+struct [[nodiscard]] scope_group_exit : basic_scope_group<detail::on_exit_policy, EF...> {
+  using basic_scope_group<detail::on_exit_policy, EF...>::basic_scope_group;
+};
+template <class... EF>
+scope_group_exit(EF...) -> scope_group_exit<EF...>;
+
+template <class... EF>
+struct [[nodiscard]] scope_group_fail : basic_scope_group<detail::on_fail_policy, EF...> {
+  using basic_scope_group<detail::on_fail_policy, EF...>::basic_scope_group;
+};
+template <class... EF>
+scope_group_fail(EF...) -> scope_group_fail<EF...>;
+
+template <class... EF>
+struct [[nodiscard]] scope_group_success : basic_scope_group<detail::on_success_policy, EF...> {
+  using basic_scope_group<detail::on_success_policy, EF...>::basic_scope_group;
+};
+template <class... EF>
+scope_group_success(EF...) -> scope_group_success<EF...>;
+
+// Calls std::uncaught_exceptions() once for all the scope_fail and
+// scope_success guards created through it, instead of once per guard. Each
+// guard still checks for an exception when it is destroyed.
+//
+//   scope::scope_frame frame;
+//   SCOPE_FRAME_FAIL(frame, [&] { undo_first(); });
+//   SCOPE_FRAME_FAIL(frame, [&] { undo_second(); });
+//
+// A frame must only be used in the function body that created it.
+class scope_frame {
+  int ec_{detail::_uncaught_exceptions()};
+
+public:
+  template <class EF>
+  [[nodiscard]] auto fail(EF &&ef) const
+      noexcept(std::is_nothrow_constructible_v<scope_fail<std::decay_t<EF>>, EF, detail::on_fail_policy const &>)
+          -> scope_fail<std::decay_t<EF>> {
+    return scope_fail<std::decay_t<EF>>(std::forward<EF>(ef), detail::on_fail_policy{ec_});
+  }
+  template <class EF>
+  [[nodiscard]] auto success(EF &&ef) const
+      noexcept(std::is_nothrow_constructible_v<scope_success<std::decay_t<EF>>, EF, detail::on_success_policy const &>)
+          -> scope_success<std::decay_t<EF>> {
+    return scope_success<std::decay_t<EF>>(std::forward<EF>(ef), detail::on_success_policy{ec_});
+  }
+};
+
 template <typename R, typename D>
 class unique_resource {
   static_assert((std::is_move_constructible_v<R> && std::is_nothrow_move_constructible_v<R>)
@@ -250,55 +920,99 @@ class unique_resource {
 
   static const unique_resource &this_; // never ODR used! Just for getting no_except() expr
 
-  detail::_box<R> resource;
-  detail::_box<D> deleter;
-  bool execute_on_destruction{true};
+  SCOPE_NO_UNIQUE_ADDRESS detail::_box<R> resource;
+  SCOPE_NO_UNIQUE_ADDRESS detail::_box<D> deleter;
+  SCOPE_NO_UNIQUE_ADDRESS detail::_ownership<R, D> execute_on_destruction{true};
 
   static constexpr auto is_nothrow_delete_v =
       std::bool_constant<noexcept(std::declval<D &>()(std::declval<R &>()))>::value;
 
+#if SCOPE_CONCEPTS
+  template <typename RR, typename DD>
+    requires detail::_box_constructible<R, RR> && detail::_box_constructible<D, DD>
+#else
   template <typename RR,
             typename DD,
             typename = std::enable_if_t<std::is_constructible_v<detail::_box<R>, RR, detail::_empty_scope_exit>
                                         && std::is_constructible_v<detail::_box<D>, DD, detail::_empty_scope_exit>>>
+#endif
   unique_resource(RR &&r,
                   DD &&d,
-                  bool should_run) noexcept(noexcept(detail::_box<R>(std::forward<RR>(r), detail::_empty_scope_exit{}))
-                                                && noexcept(detail::_box<D>(std::forward<DD>(d),
-                                                                            detail::_empty_scope_exit{})))
-      : resource{std::forward<RR>(r), scope_exit([&] {
+                  bool should_run SCOPE_WHERE_PARAM)
+      noexcept(noexcept(detail::_box<R>(std::forward<RR>(r), detail::_empty_scope_exit{}))
+               && noexcept(detail::_box<D>(std::forward<DD>(d), detail::_empty_scope_exit{})))
+      : resource{std::forward<RR>(r), detail::_quiet_exit([&] {
                    if (should_run)
                      d(r);
                  })}
-      , deleter{std::forward<DD>(d), scope_exit([&, this] {
+      , deleter{std::forward<DD>(d), detail::_quiet_exit([&, this] {
                   if (should_run)
                     d(get());
                 })}
-      , execute_on_destruction{should_run} {}
+      , execute_on_destruction{should_run} {
+    if (!should_run)
+      execute_on_destruction.disown(resource);
+#if SCOPE_INSTRUMENTATION
+    else if (execute_on_destruction.owns(resource))
+      detail::_notify<unique_resource>(scope_event::constructed, this, detail::_handle_of(get()), where);
+#endif
+  }
   friend struct detail::hidden::factory_holder; // a level of indirection is
                                                 // the trick...
 public:
+#if SCOPE_CONCEPTS
+  template <typename RR, typename DD>
+    requires detail::_box_constructible<R, RR> && detail::_box_constructible<D, DD>
+#else
   template <
       typename RR,
       typename DD,
       typename = std::enable_if_t<std::is_constructible<detail::_box<R>, RR, detail::_empty_scope_exit>::value
                                   && std::is_constructible<detail::_box<D>, DD, detail::_empty_scope_exit>::value>>
+#endif
   unique_resource(RR &&r,
-                  DD &&d) noexcept(noexcept(detail::_box<R>(std::forward<RR>(r), detail::_empty_scope_exit{}))
-                                       && noexcept(detail::_box<D>(std::forward<DD>(d), detail::_empty_scope_exit{})))
-      : resource(std::forward<RR>(r), scope_exit([&] { d(r); }))
-      , deleter(std::forward<DD>(d), scope_exit([&, this] { d(get()); })) {}
+                  DD &&d SCOPE_WHERE_PARAM)
+      noexcept(noexcept(detail::_box<R>(std::forward<RR>(r), detail::_empty_scope_exit{}))
+               && noexcept(detail::_box<D>(std::forward<DD>(d), detail::_empty_scope_exit{})))
+      : resource(std::forward<RR>(r), detail::_quiet_exit([&] { d(r); }))
+      , deleter(std::forward<DD>(d), detail::_quiet_exit([&, this] { d(get()); })) {
+#if SCOPE_INSTRUMENTATION
+    // an invalid value is not owned, as for the destructor
+    if (execute_on_destruction.owns(resource))
+      detail::_notify<unique_resource>(scope_event::constructed, this, detail::_handle_of(get()), where);
+#endif
+  }
+  // for deleters that need no state, e.g. function_deleter, not for function
+  // pointers, which would be null
+#if SCOPE_CONCEPTS
+  template <typename RR>
+    requires std::is_empty_v<D> && std::is_default_constructible_v<D> && detail::_box_constructible<R, RR>
+             && detail::_box_constructible<D, D>
+#else
+  template <typename RR,
+            typename DD = D,
+            typename    = std::enable_if_t<std::is_empty_v<DD> && std::is_default_constructible_v<DD>
+                                        && std::is_constructible_v<detail::_box<R>, RR, detail::_empty_scope_exit>
+                                        && std::is_constructible_v<detail::_box<D>, D, detail::_empty_scope_exit>>>
+#endif
+  explicit unique_resource(RR &&r SCOPE_WHERE_PARAM)
+      noexcept(noexcept(detail::_box<R>(std::forward<RR>(r), detail::_empty_scope_exit{}))
+               && std::is_nothrow_default_constructible_v<D>
+               && noexcept(detail::_box<D>(std::declval<D>(), detail::_empty_scope_exit{})))
+      : unique_resource(std::forward<RR>(r), D{} SCOPE_WHERE_ARG) {}
   unique_resource(unique_resource &&that) noexcept(noexcept(detail::_box<R>(that.resource.move(),
                                                                             detail::_empty_scope_exit{}))
                                                        && noexcept(detail::_box<D>(that.deleter.move(),
                                                                                    detail::_empty_scope_exit{})))
       : resource(that.resource.move(), detail::_empty_scope_exit{})
-      , deleter(that.deleter.move(), scope_exit([&, this] {
-                  if (that.execute_on_destruction)
+      , deleter(that.deleter.move(), detail::_quiet_exit([&, this] {
+                  if (that.execute_on_destruction.owns(resource))
                     that.get_deleter()(get());
-                  that.release();
+                  that.execute_on_destruction.disown(that.resource);
                 }))
-      , execute_on_destruction(std::exchange(that.execute_on_destruction, false)) {}
+      , execute_on_destruction(that.execute_on_destruction) {
+    that.execute_on_destruction.disown(that.resource);
+  }
 
   unique_resource &operator=(unique_resource &&that) noexcept(is_nothrow_delete_v &&std::is_nothrow_move_assignable_v<R>
                                                                   &&std::is_nothrow_move_assignable_v<D>) {
@@ -313,17 +1027,18 @@ public:
           resource = std::move(that.resource);
           deleter  = std::move(that.deleter);
         } else {
-          deleter  = _as_const(that.deleter);
+          deleter  = std::as_const(that.deleter);
           resource = std::move(that.resource);
         }
       else if constexpr (std::is_nothrow_move_assignable_v<detail::_box<D>>) {
-        resource = _as_const(that.resource);
+        resource = std::as_const(that.resource);
         deleter  = std::move(that.deleter);
       } else {
-        resource = _as_const(that.resource);
-        deleter  = _as_const(that.deleter);
+        resource = std::as_const(that.resource);
+        deleter  = std::as_const(that.deleter);
       }
-      execute_on_destruction = std::exchange(that.execute_on_destruction, false);
+      execute_on_destruction = that.execute_on_destruction;
+      that.execute_on_destruction.disown(that.resource);
     }
     return *this;
   }
@@ -332,21 +1047,45 @@ public:
   }
 
   void reset() noexcept {
-    if (execute_on_destruction) {
-      execute_on_destruction = false;
-      get_deleter()(get());
+    if (execute_on_destruction.owns(resource)) {
+      if constexpr (decltype(execute_on_destruction)::uses_sentinel) {
+        auto const r = get();
+        execute_on_destruction.disown(resource);
+#if SCOPE_INSTRUMENTATION
+        detail::_notify_timed<unique_resource>(
+            scope_event::deleted, this, detail::_handle_of(r), [&] { get_deleter()(r); });
+#else
+        get_deleter()(r);
+#endif
+      } else {
+        execute_on_destruction.disown(resource);
+#if SCOPE_INSTRUMENTATION
+        detail::_notify_timed<unique_resource>(
+            scope_event::deleted, this, detail::_handle_of(get()), [&] { get_deleter()(get()); });
+#else
+        get_deleter()(get());
+#endif
+      }
     }
   }
   template <typename RR>
-  auto reset(RR &&r) noexcept(noexcept(resource.reset(std::forward<RR>(r))))
+  auto reset(RR &&r SCOPE_WHERE_PARAM) noexcept(noexcept(resource.reset(std::forward<RR>(r))))
       -> decltype(resource.reset(std::forward<RR>(r)), void()) {
-    auto &&guard = scope_fail([&, this] { get_deleter()(r); }); // -Wunused-variable on clang
+    auto &&guard = detail::_quiet_fail([&, this] { get_deleter()(r); }); // -Wunused-variable on clang
     reset();
     resource.reset(std::forward<RR>(r));
-    execute_on_destruction = true;
+    execute_on_destruction.own(resource);
+#if SCOPE_INSTRUMENTATION
+    if (execute_on_destruction.owns(resource))
+      detail::_notify<unique_resource>(scope_event::reset, this, detail::_handle_of(get()), where);
+#endif
   }
   void release() noexcept {
-    execute_on_destruction = false;
+#if SCOPE_INSTRUMENTATION
+    if (execute_on_destruction.owns(resource))
+      detail::_notify<unique_resource>(scope_event::released, this, detail::_handle_of(get()));
+#endif
+    execute_on_destruction.disown(resource);
   }
   decltype(auto) get() const noexcept {
     return resource.get();
@@ -356,6 +1095,18 @@ public:
   }
   // THIS IS NOT A POINTER TYPE, the following operations are only available
   // if R is a native pointer
+#if SCOPE_CONCEPTS
+  auto operator->() const noexcept
+    requires std::is_pointer_v<R>
+  {
+    return get();
+  }
+  decltype(auto) operator*() const noexcept
+    requires std::is_pointer_v<R> && (!std::is_void_v<std::remove_pointer_t<R>>)
+  {
+    return *get();
+  }
+#else
   template <typename RR = R>
   auto operator->() const noexcept -> std::enable_if_t<std::is_pointer_v<RR>, decltype(get())> {
     return get();
@@ -366,6 +1117,7 @@ public:
                           std::add_lvalue_reference_t<std::remove_pointer_t<R>>> {
     return *get();
   }
+#endif
 
   // implicitly deleted:
   //	unique_resource& operator=(const unique_resource &) = delete;
@@ -375,33 +1127,87 @@ namespace detail {
 namespace hidden {
 struct factory_holder {
   template <typename MR, typename MD>
-  static auto special_maker(MR &&r, MD &&d, bool shouldrun) {
-    unique_resource<std::decay_t<MR>, std::decay_t<MD>> resource{std::forward<MR>(r), std::forward<MD>(d), shouldrun};
+  static auto special_maker(MR &&r, MD &&d, bool shouldrun SCOPE_WHERE_PARAM) {
+    unique_resource<std::decay_t<MR>, std::decay_t<MD>> resource{
+        std::forward<MR>(r), std::forward<MD>(d), shouldrun SCOPE_WHERE_ARG};
     return resource;
   }
+  // whether r has to delete its resource, e.g. to not share one it does not own
+  template <typename R, typename D>
+  static bool owns(unique_resource<R, D> const &r) noexcept {
+    return r.execute_on_destruction.owns(r.resource);
+  }
 };
 } // namespace hidden
 } // namespace detail
 
+// A deleter calling the function Fn, which is known at compile time. Unlike a
+// function pointer deleter, it takes no space and the call is direct.
+template <auto Fn>
+struct function_deleter {
+  template <typename R>
+  auto operator()(R &&r) const noexcept(noexcept(Fn(std::forward<R>(r)))) -> decltype(void(Fn(std::forward<R>(r)))) {
+    Fn(std::forward<R>(r));
+  }
+};
+
+//   scope::unique_resource_fn<int, &::close> fd{::open(name, O_RDONLY)};
+template <typename R, auto Fn>
+using unique_resource_fn = unique_resource<R, function_deleter<Fn>>;
+
 template <typename R, typename D>
 unique_resource(R, D) -> unique_resource<R, D>;
 template <typename R, typename D>
 unique_resource(R, D, bool) -> unique_resource<R, D>;
 
 template <typename MR, typename MD, typename S>
-[[nodiscard]] auto make_unique_resource_checked(MR &&r,
-                                                const S &invalid,
-                                                MD &&d) noexcept(std::is_nothrow_constructible_v<std::decay_t<MR>, MR>
-                                                                     &&std::is_nothrow_constructible_v<std::decay_t<MD>,
-                                                                                                       MD>)
+[[nodiscard]] auto make_unique_resource_checked(MR &&r, const S &invalid, MD &&d SCOPE_WHERE_PARAM) noexcept(
+    std::is_nothrow_constructible_v<std::decay_t<MR>, MR> && std::is_nothrow_constructible_v<std::decay_t<MD>, MD>)
     -> unique_resource<std::decay_t<MR>, std::decay_t<MD>> {
   bool const mustrelease(r == invalid);
-  auto resource = detail::hidden::factory_holder::special_maker(std::forward<MR>(r), std::forward<MD>(d), !mustrelease);
+  auto resource = detail::hidden::factory_holder::special_maker(
+      std::forward<MR>(r), std::forward<MD>(d), !mustrelease SCOPE_WHERE_ARG);
   //	unique_resource resource{std::forward<MR>(r),
   // std::forward<MD>(d),!mustrelease};
   return resource;
 }
 
+//   auto fd = scope::make_unique_resource_checked<&::close>(::open(name, O_RDONLY), -1);
+template <auto Fn, typename MR, typename S>
+[[nodiscard]] auto make_unique_resource_checked(MR &&r, const S &invalid SCOPE_WHERE_PARAM) noexcept(
+    std::is_nothrow_constructible_v<std::decay_t<MR>, MR>) -> unique_resource_fn<std::decay_t<MR>, Fn> {
+  return make_unique_resource_checked(std::forward<MR>(r), invalid, function_deleter<Fn>{} SCOPE_WHERE_ARG);
+}
+
+namespace detail {
+// a reference member is stored as a pointer by _box
+template <typename T>
+inline constexpr bool _relocatable_member_v = std::is_reference_v<T> || is_trivially_relocatable_v<T>;
+} // namespace detail
+
+// Neither the guards nor unique_resource refer to their own address, so they
+// are trivially relocatable if their members are.
+template <typename EF, typename Policy>
+struct is_trivially_relocatable<basic_scope_exit<EF, Policy>>
+    : std::bool_constant<detail::_relocatable_member_v<EF> && is_trivially_relocatable_v<Policy>> {};
+template <typename EF>
+struct is_trivially_relocatable<scope_exit<EF>> : is_trivially_relocatable<basic_scope_exit<EF>> {};
+template <typename EF>
+struct is_trivially_relocatable<scope_fail<EF>>
+    : is_trivially_relocatable<basic_scope_exit<EF, detail::on_fail_policy>> {};
+template <typename EF>
+struct is_trivially_relocatable<scope_success<EF>>
+    : is_trivially_relocatable<basic_scope_exit<EF, detail::on_success_policy>> {};
+template <typename S, typename EF>
+struct is_trivially_relocatable<scope_fail_on<S, EF>>
+    : is_trivially_relocatable<basic_scope_exit<EF, detail::on_status_fail_policy<S>>> {};
+template <typename S, typename EF>
+struct is_trivially_relocatable<scope_success_on<S, EF>>
+    : is_trivially_relocatable<basic_scope_exit<EF, detail::on_status_success_policy<S>>> {};
+template <typename R, typename D>
+struct is_trivially_relocatable<unique_resource<R, D>>
+    : std::bool_constant<detail::_relocatable_member_v<R> && detail::_relocatable_member_v<D>> {};
+
 } // namespace scope
 
 #endif // SCOPE_HPP_INCLUDE
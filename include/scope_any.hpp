@@ -0,0 +1,311 @@
+#ifndef SCOPE_ANY_HPP_INCLUDE
+#define SCOPE_ANY_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace scope {
+namespace detail {
+
+struct _erased_ops {
+  void (*invoke)(void *self);
+  // move constructs the callable at dst from the one at src and destroys the
+  // latter
+  void (*relocate)(void *dst, void *src) noexcept;
+  void (*destroy)(void *self) noexcept;
+};
+
+template <typename F, std::size_t Size>
+inline constexpr bool _stores_inline_v = sizeof(F) <= Size && alignof(F) <= alignof(std::max_align_t)
+                                      && std::is_nothrow_move_constructible_v<F>;
+
+// callables that don't fit the buffer are allocated, the buffer holds a
+// pointer to them then
+template <typename F, bool Inline>
+struct _erased {
+  static F &get(void *self) noexcept {
+    if constexpr (Inline)
+      return *std::launder(static_cast<F *>(self));
+    else
+      return **static_cast<F **>(self);
+  }
+  static void invoke(void *self) {
+    get(self)();
+  }
+  static void relocate(void *dst, void *src) noexcept {
+    if constexpr (Inline) {
+      ::new (dst) F(std::move(get(src)));
+      get(src).~F();
+    } else {
+      ::new (dst) F *(*static_cast<F **>(src));
+    }
+  }
+  static void destroy(void *self) noexcept {
+    if constexpr (Inline)
+      get(self).~F();
+    else
+      delete &get(self);
+  }
+
+  static constexpr _erased_ops ops{&invoke, &relocate, &destroy};
+};
+
+// A move only void() callable that does not allocate for callables of up to
+// Size bytes which are nothrow move constructible.
+template <std::size_t Size>
+class _inline_function {
+  static_assert(Size >= sizeof(void *), "the buffer must be able to hold a pointer");
+
+  _erased_ops const *ops_{nullptr};
+  alignas(std::max_align_t) std::byte storage_[Size];
+
+public:
+  template <typename F>
+  static constexpr bool stores_inline = _stores_inline_v<F, Size>;
+
+  _inline_function() noexcept = default;
+  _inline_function(_inline_function &&that) noexcept
+      : ops_{std::exchange(that.ops_, nullptr)} {
+    if (ops_)
+      ops_->relocate(storage_, that.storage_);
+  }
+  _inline_function &operator=(_inline_function &&that) noexcept {
+    if (&that != this) {
+      reset();
+      if ((ops_ = std::exchange(that.ops_, nullptr)))
+        ops_->relocate(storage_, that.storage_);
+    }
+    return *this;
+  }
+  ~_inline_function() {
+    reset();
+  }
+
+  // Requires: *this is empty
+  template <typename F, typename FF>
+  void emplace(FF &&f) {
+    if constexpr (stores_inline<F>)
+      ::new (static_cast<void *>(storage_)) F(std::forward<FF>(f));
+    else
+      ::new (static_cast<void *>(storage_)) F *(new F(std::forward<FF>(f)));
+    ops_ = &_erased<F, stores_inline<F>>::ops;
+  }
+  void reset() noexcept {
+    if (auto const *ops = std::exchange(ops_, nullptr))
+      ops->destroy(storage_);
+  }
+
+  void operator()() {
+    ops_->invoke(storage_);
+  }
+  explicit operator bool() const noexcept {
+    return ops_ != nullptr;
+  }
+};
+} // namespace detail
+
+// A scope guard whose type does not depend on its exit function, so it can
+// be returned from functions and stored in members without naming a lambda
+// type. Exit functions of up to Size bytes which are nothrow move
+// constructible are stored inline, larger ones are allocated.
+//
+// An exception escaping from the exit function terminates the program.
+template <class Policy, std::size_t Size>
+class [[nodiscard]] basic_any_scope_exit : Policy {
+  detail::_inline_function<Size> exit_function;
+
+public:
+  // Requires: EF is Callable
+  template <typename EFP, typename = std::enable_if_t<std::is_invocable_v<std::decay_t<EFP> &>>>
+  explicit basic_any_scope_exit(EFP &&ef) noexcept(
+      std::is_nothrow_constructible_v<std::decay_t<EFP>, EFP>
+      && detail::_inline_function<Size>::template stores_inline<std::decay_t<EFP>>) {
+    using EF = std::decay_t<EFP>;
+    if constexpr (std::is_nothrow_constructible_v<EF, EFP>
+                  && detail::_inline_function<Size>::template stores_inline<EF>) {
+      exit_function.template emplace<EF>(std::forward<EFP>(ef));
+    } else {
+      // invokes ef if storing it fails, as basic_scope_exit does
+      auto failsafe =
+          basic_scope_exit<std::remove_reference_t<EFP> &, detail::_quiet<Policy>>(ef, detail::_quiet<Policy>(*this));
+      exit_function.template emplace<EF>(detail::_forward_keeping<EF, EFP>(ef));
+      failsafe.release();
+    }
+  }
+  basic_any_scope_exit(basic_any_scope_exit &&that) noexcept
+      : Policy(that)
+      , exit_function(std::move(that.exit_function)) {
+    that.release();
+  }
+  ~basic_any_scope_exit() {
+    if (exit_function && this->should_execute())
+      exit_function();
+  }
+
+  using Policy::release;
+};
+
+template <std::size_t Size = 4 * sizeof(void *)>
+struct [[nodiscard]] any_scope_exit : basic_any_scope_exit<detail::on_exit_policy, Size> {
+  using basic_any_scope_exit<detail::on_exit_policy, Size>::basic_any_scope_exit;
+};
+
+template <class EF>
+any_scope_exit(EF) -> any_scope_exit<>;
+
+template <std::size_t Size = 4 * sizeof(void *)>
+struct [[nodiscard]] any_scope_fail : basic_any_scope_exit<detail::on_fail_policy, Size> {
+  using basic_any_scope_exit<detail::on_fail_policy, Size>::basic_any_scope_exit;
+};
+
+template <class EF>
+any_scope_fail(EF) -> any_scope_fail<>;
+
+template <std::size_t Size = 4 * sizeof(void *)>
+struct [[nodiscard]] any_scope_success : basic_any_scope_exit<detail::on_success_policy, Size> {
+  using basic_any_scope_exit<detail::on_success_policy, Size>::basic_any_scope_exit;
+};
+
+template <class EF>
+any_scope_success(EF) -> any_scope_success<>;
+
+namespace detail {
+enum class _any_resource_op { release, relocate, destroy };
+
+// The one function a unique_any_resource calls for all operations on the
+// unique_resource it holds, inline or allocated like _erased.
+template <typename R, typename D, bool Inline>
+struct _erased_resource {
+  using resource = unique_resource<R, D>;
+
+  static resource &get(void *self) noexcept {
+    if constexpr (Inline)
+      return *std::launder(static_cast<resource *>(self));
+    else
+      return **static_cast<resource **>(self);
+  }
+  // destroying the unique_resource deletes the resource if it owns it
+  static void manage(_any_resource_op op, void *self, void *dst) noexcept {
+    switch (op) {
+    case _any_resource_op::release:
+      get(self).release();
+      break;
+    case _any_resource_op::relocate:
+      if constexpr (Inline) {
+        ::new (dst) resource(std::move(get(self)));
+        get(self).~resource();
+      } else {
+        ::new (dst) resource *(*static_cast<resource **>(self));
+      }
+      break;
+    case _any_resource_op::destroy:
+      if constexpr (Inline)
+        get(self).~resource();
+      else
+        delete &get(self);
+      break;
+    }
+  }
+};
+} // namespace detail
+
+// Owns a unique_resource of any resource and deleter type, e.g. to tear down
+// the file descriptors, FILE pointers and mappings of a session together from
+// one container. A unique_resource of up to Size bytes which is nothrow move
+// constructible is stored inline, a larger one is allocated. All operations go
+// through a single function pointer.
+//
+//   std::vector<scope::unique_any_resource<>> session;
+//   session.emplace_back(scope::make_unique_resource_checked<&::close>(::open(name, O_RDONLY), -1));
+//   session.emplace_back(std::fopen(log, "a"), &::fclose);
+//
+// reset() and release() behave as for unique_resource, both leave it empty.
+template <std::size_t Size = 4 * sizeof(void *)>
+class unique_any_resource {
+  static_assert(Size >= sizeof(void *), "the buffer must be able to hold a pointer");
+
+  void (*manage_)(detail::_any_resource_op, void *, void *) noexcept {nullptr};
+  alignas(std::max_align_t) std::byte storage_[Size];
+
+  template <typename R, typename D>
+  using erased = detail::_erased_resource<R, D, detail::_stores_inline_v<unique_resource<R, D>, Size>>;
+
+public:
+  template <typename R, typename D>
+  static constexpr bool stores_inline = detail::_stores_inline_v<unique_resource<R, D>, Size>;
+
+  // owns nothing
+  unique_any_resource() noexcept = default;
+  // Takes the ownership of the resource of r. If r has to be allocated and
+  // that fails, r is left unchanged.
+  template <typename R, typename D>
+  unique_any_resource(unique_resource<R, D> &&r) noexcept(stores_inline<R, D>) {
+    if constexpr (stores_inline<R, D>)
+      ::new (static_cast<void *>(storage_)) unique_resource<R, D>(std::move(r));
+    else
+      ::new (static_cast<void *>(storage_)) unique_resource<R, D> *(new unique_resource<R, D>(std::move(r)));
+    manage_ = &erased<R, D>::manage;
+  }
+  // If the resource has to be allocated and that fails, it is deleted before
+  // the exception propagates.
+  template <typename RR,
+            typename DD,
+            typename = std::enable_if_t<std::is_constructible_v<unique_resource<std::decay_t<RR>, std::decay_t<DD>>,
+                                                                RR,
+                                                                DD>>>
+  unique_any_resource(RR &&r, DD &&d)
+      : unique_any_resource(unique_resource<std::decay_t<RR>, std::decay_t<DD>>(std::forward<RR>(r),
+                                                                                std::forward<DD>(d))) {}
+  unique_any_resource(unique_any_resource &&that) noexcept
+      : manage_{std::exchange(that.manage_, nullptr)} {
+    if (manage_)
+      manage_(detail::_any_resource_op::relocate, that.storage_, storage_);
+  }
+  unique_any_resource &operator=(unique_any_resource &&that) noexcept {
+    if (&that != this) {
+      reset();
+      if ((manage_ = std::exchange(that.manage_, nullptr)))
+        manage_(detail::_any_resource_op::relocate, that.storage_, storage_);
+    }
+    return *this;
+  }
+  ~unique_any_resource() {
+    reset();
+  }
+
+  // deletes the resource
+  void reset() noexcept {
+    if (auto const manage = std::exchange(manage_, nullptr))
+      manage(detail::_any_resource_op::destroy, storage_, nullptr);
+  }
+  // gives up the ownership of the resource without deleting it
+  void release() noexcept {
+    if (auto const manage = std::exchange(manage_, nullptr)) {
+      manage(detail::_any_resource_op::release, storage_, nullptr);
+      manage(detail::_any_resource_op::destroy, storage_, nullptr);
+    }
+  }
+
+  // The unique_resource held if it is a unique_resource<R, D>, nullptr
+  // otherwise.
+  template <typename R, typename D>
+  unique_resource<R, D> *target() noexcept {
+    return manage_ == &erased<R, D>::manage ? &erased<R, D>::get(storage_) : nullptr;
+  }
+  template <typename R, typename D>
+  unique_resource<R, D> const *target() const noexcept {
+    return const_cast<unique_any_resource *>(this)->template target<R, D>();
+  }
+  // whether it holds a unique_resource
+  explicit operator bool() const noexcept {
+    return manage_ != nullptr;
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_ANY_HPP_INCLUDE
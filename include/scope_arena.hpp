@@ -0,0 +1,223 @@
+#ifndef SCOPE_ARENA_HPP_INCLUDE
+#define SCOPE_ARENA_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#if !__has_include(<memory_resource>)
+#error "scope_arena.hpp requires <memory_resource>"
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+#ifdef __COUNTER__
+#define SCOPE_ARENA(arena) auto SCOPE_CONCAT(scope_, __COUNTER__) = (arena).scope()
+#define SCOPE_ARENA_DEFAULT(arena) auto SCOPE_CONCAT(scope_, __COUNTER__) = (arena).scope(true)
+#else
+#define SCOPE_ARENA(arena) auto SCOPE_CONCAT(scope_, __LINE__) = (arena).scope()
+#define SCOPE_ARENA_DEFAULT(arena) auto SCOPE_CONCAT(scope_, __LINE__) = (arena).scope(true)
+#endif
+
+namespace scope {
+namespace detail {
+inline std::pmr::memory_resource *&_thread_resource() noexcept {
+  static thread_local std::pmr::memory_resource *resource{nullptr};
+  return resource;
+}
+} // namespace detail
+
+// The memory resource installed for the calling thread by SCOPE_ARENA_DEFAULT,
+// std::pmr::get_default_resource() outside of one. Unlike the latter, it is
+// per thread.
+//
+//   std::pmr::vector<int> ids{scope::current_memory_resource()};
+inline std::pmr::memory_resource *current_memory_resource() noexcept {
+  auto *resource = detail::_thread_resource();
+  return resource ? resource : std::pmr::get_default_resource();
+}
+
+class scope_arena;
+
+namespace detail {
+struct _arena_chunk {
+  _arena_chunk *prev;
+  std::size_t size;
+
+  std::byte *begin() noexcept {
+    return reinterpret_cast<std::byte *>(this + 1);
+  }
+  std::byte *end() noexcept {
+    return begin() + size;
+  }
+};
+
+struct _arena_rewind;
+} // namespace detail
+
+// A monotonic memory resource whose allocations are freed together, by
+// rewinding it to a mark taken earlier. Allocating bumps a pointer and
+// deallocating does nothing. Memory comes from an optional initial buffer,
+// then from chunks of the upstream resource. Chunks freed by rewinding are
+// kept for reuse until release() or the destruction of the arena.
+//
+// SCOPE_ARENA(arena) rewinds the arena at the end of the scope to where it
+// was at its beginning, so nested scopes only free what they allocated:
+//
+//   scope::scope_arena arena{};
+//
+//   void handle(request const &req) {
+//     SCOPE_ARENA(arena);
+//     std::pmr::vector<token> tokens{&arena};
+//     ...
+//   } // all the memory allocated from arena since the beginning is freed
+class scope_arena : public std::pmr::memory_resource {
+public:
+  struct mark {
+    detail::_arena_chunk *chunk;
+    std::byte *position;
+  };
+
+private:
+  std::pmr::memory_resource *upstream_;
+  std::size_t chunk_size_;
+  std::byte *buffer_end_{nullptr};
+  std::byte *position_{nullptr};
+  std::byte *end_{nullptr};
+  detail::_arena_chunk *chunks_{nullptr}; // newest first
+  detail::_arena_chunk *spare_{nullptr};
+  mark const initial_;
+
+  static constexpr std::size_t chunk_alignment_ = alignof(std::max_align_t);
+
+  detail::_arena_chunk *_take_chunk(std::size_t size) {
+    for (auto **link = &spare_; *link; link = &(*link)->prev) {
+      if ((*link)->size >= size) {
+        auto *chunk = *link;
+        *link       = chunk->prev;
+        return chunk;
+      }
+    }
+    if (size < chunk_size_)
+      size = chunk_size_;
+    auto *chunk = static_cast<detail::_arena_chunk *>(
+        upstream_->allocate(sizeof(detail::_arena_chunk) + size, chunk_alignment_));
+    return ::new (static_cast<void *>(chunk)) detail::_arena_chunk{nullptr, size};
+  }
+
+  void *_allocate_slow(std::size_t bytes, std::size_t alignment) {
+    auto *chunk = _take_chunk(bytes + alignment);
+    chunk->prev = chunks_;
+    chunks_     = chunk;
+    position_   = chunk->begin();
+    end_        = chunk->end();
+    return _bump(bytes, alignment);
+  }
+
+  void *_bump(std::size_t bytes, std::size_t alignment) noexcept {
+    void *p    = position_;
+    auto space = static_cast<std::size_t>(end_ - position_);
+    if (!position_ || !std::align(alignment, bytes, p, space))
+      return nullptr;
+    position_ = static_cast<std::byte *>(p) + bytes;
+    return p;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (auto *p = _bump(bytes, alignment))
+      return p;
+    return _allocate_slow(bytes, alignment);
+  }
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+  bool do_is_equal(std::pmr::memory_resource const &that) const noexcept override {
+    return this == &that;
+  }
+
+public:
+  // Requires: chunk_size > 0, the minimum size of the chunks taken from upstream
+  explicit scope_arena(std::size_t chunk_size              = 64 * 1024,
+                       std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) noexcept
+      : upstream_{upstream}
+      , chunk_size_{chunk_size}
+      , initial_{nullptr, nullptr} {}
+  // allocates from buffer before taking chunks from upstream
+  scope_arena(void *buffer,
+              std::size_t size,
+              std::size_t chunk_size              = 64 * 1024,
+              std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) noexcept
+      : upstream_{upstream}
+      , chunk_size_{chunk_size}
+      , buffer_end_{static_cast<std::byte *>(buffer) + size}
+      , position_{static_cast<std::byte *>(buffer)}
+      , end_{buffer_end_}
+      , initial_{nullptr, static_cast<std::byte *>(buffer)} {}
+  scope_arena(scope_arena const &)            = delete;
+  scope_arena &operator=(scope_arena const &) = delete;
+  ~scope_arena() override {
+    release();
+  }
+
+  // where the next allocation starts
+  mark position() const noexcept {
+    return mark{chunks_, position_};
+  }
+
+  // Frees everything allocated since m was taken, keeping the chunks for
+  // reuse. Requires: marks are rewound to in the reverse order of being taken
+  void rewind(mark m) noexcept {
+    while (chunks_ != m.chunk) {
+      auto *chunk = chunks_;
+      chunks_     = chunk->prev;
+      chunk->prev = spare_;
+      spare_      = chunk;
+    }
+    position_ = m.position;
+    end_      = chunks_ ? chunks_->end() : buffer_end_;
+  }
+
+  // frees everything and gives the chunks back to upstream
+  void release() noexcept {
+    rewind(initial_);
+    while (spare_) {
+      auto *chunk = spare_;
+      spare_      = chunk->prev;
+      upstream_->deallocate(chunk, sizeof(detail::_arena_chunk) + chunk->size, chunk_alignment_);
+    }
+  }
+
+  // Returns a guard rewinding the arena to its current position. If
+  // as_default is true, the arena is also the current_memory_resource() of
+  // the calling thread until then.
+  [[nodiscard]] scope_exit<detail::_arena_rewind> scope(bool as_default = false) noexcept;
+
+  std::pmr::memory_resource *upstream_resource() const noexcept {
+    return upstream_;
+  }
+};
+
+namespace detail {
+struct _arena_rewind {
+  scope_arena *arena;
+  scope_arena::mark mark;
+  std::pmr::memory_resource *previous; // the thread's resource to restore
+  bool installed;
+
+  void operator()() const noexcept {
+    if (installed)
+      _thread_resource() = previous;
+    arena->rewind(mark);
+  }
+};
+} // namespace detail
+
+inline scope_exit<detail::_arena_rewind> scope_arena::scope(bool as_default) noexcept {
+  auto *previous = detail::_thread_resource();
+  if (as_default)
+    detail::_thread_resource() = this;
+  return scope_exit<detail::_arena_rewind>{detail::_arena_rewind{this, position(), previous, as_default}};
+}
+
+} // namespace scope
+
+#endif // SCOPE_ARENA_HPP_INCLUDE
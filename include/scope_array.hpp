@@ -0,0 +1,174 @@
+#ifndef SCOPE_ARRAY_HPP_INCLUDE
+#define SCOPE_ARRAY_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <algorithm>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace scope {
+
+// Owns many resources that share a deleter and releases them together, e.g.
+// all the sockets of a worker. The resources are stored contiguously and
+// being stored is what makes them owned, so there is no ownership flag per
+// resource.
+//
+// If the deleter can be called with a range of resources, d(R *first, R *last),
+// it is called once for all of them when they are released. Otherwise it is
+// called for each resource in reverse order of insertion.
+template <typename R, typename D>
+class unique_resource_array {
+  static_assert(std::is_nothrow_move_constructible_v<R>, "resource must be nothrow_move_constructible");
+  static_assert(!std::is_reference_v<R>, "resource can not be a reference");
+
+  std::vector<R> resources_;
+  SCOPE_NO_UNIQUE_ADDRESS D deleter_;
+
+  static constexpr bool batch_delete_v = std::is_invocable_v<D &, R *, R *>;
+
+  void _delete_all() noexcept {
+    if constexpr (batch_delete_v) {
+      deleter_(resources_.data(), resources_.data() + resources_.size());
+    } else {
+      for (auto it = resources_.rbegin(); it != resources_.rend(); ++it) {
+        deleter_(*it);
+      }
+    }
+  }
+  void _delete_one(R &r) noexcept {
+    if constexpr (batch_delete_v)
+      deleter_(&r, &r + 1);
+    else
+      deleter_(r);
+  }
+
+  void _grow_and_push_back(R r) {
+    auto guard = detail::_quiet_fail([&] { _delete_one(r); });
+    resources_.push_back(std::move(r));
+  }
+
+public:
+  unique_resource_array() = default;
+  explicit unique_resource_array(D d) noexcept(std::is_nothrow_move_constructible_v<D>)
+      : deleter_(std::move(d)) {}
+  unique_resource_array(unique_resource_array &&that) noexcept(std::is_nothrow_move_constructible_v<D>)
+      : resources_(std::move(that.resources_))
+      , deleter_(std::move(that.deleter_)) {
+    that.resources_.clear();
+  }
+  unique_resource_array &operator=(unique_resource_array &&that) noexcept(std::is_nothrow_move_assignable_v<D>) {
+    if (&that != this) {
+      reset();
+      resources_ = std::move(that.resources_);
+      deleter_   = std::move(that.deleter_);
+      that.resources_.clear();
+    }
+    return *this;
+  }
+  ~unique_resource_array() {
+    reset();
+  }
+
+  // Takes ownership of r. If r can not be stored, it is deleted before the
+  // exception propagates, as a unique_resource failing to be constructed does.
+  void push_back(R r) {
+    if (resources_.size() != resources_.capacity())
+      resources_.push_back(std::move(r));
+    else
+      _grow_and_push_back(std::move(r));
+  }
+  // Takes ownership of r unless r == invalid, returns whether it did.
+  template <typename S>
+  bool push_back_checked(R r, S const &invalid) {
+    if (r == invalid)
+      return false;
+    push_back(std::move(r));
+    return true;
+  }
+
+  // Moves the resource at index i into a unique_resource of its own, the
+  // last resource takes its place.
+  unique_resource<R, D> extract(std::size_t i) {
+    auto r = std::move(resources_[i]);
+    resources_[i] = std::move(resources_.back());
+    resources_.pop_back();
+    return unique_resource<R, D>(std::move(r), deleter_);
+  }
+
+  // releases all the resources with a single call to a batch deleter
+  void reset() noexcept {
+    if (!resources_.empty()) {
+      _delete_all();
+      resources_.clear();
+    }
+  }
+  // gives up the ownership of all the resources without deleting them
+  void release() noexcept {
+    resources_.clear();
+  }
+
+  void reserve(std::size_t n) {
+    resources_.reserve(n);
+  }
+  std::size_t size() const noexcept {
+    return resources_.size();
+  }
+  bool empty() const noexcept {
+    return resources_.empty();
+  }
+  R const &operator[](std::size_t i) const noexcept {
+    return resources_[i];
+  }
+  R const *data() const noexcept {
+    return resources_.data();
+  }
+  R const *begin() const noexcept {
+    return resources_.data();
+  }
+  R const *end() const noexcept {
+    return resources_.data() + resources_.size();
+  }
+  D const &get_deleter() const noexcept {
+    return deleter_;
+  }
+};
+
+#if defined(__linux__)
+// Batch deleter for file descriptors. It closes each run of consecutive
+// descriptors with a single close_range(2) call where the kernel supports it.
+struct close_fd_range {
+  void operator()(int fd) const noexcept {
+    ::close(fd);
+  }
+  void operator()(int *first, int *last) const noexcept {
+    std::sort(first, last);
+    while (first != last) {
+      auto *run = first + 1;
+      while (run != last && *run == *(run - 1) + 1) {
+        ++run;
+      }
+#if defined(SYS_close_range)
+      if (run - first > 1 && ::syscall(SYS_close_range, *first, *(run - 1), 0) == 0) {
+        first = run;
+        continue;
+      }
+#endif
+      for (; first != run; ++first) {
+        ::close(*first);
+      }
+    }
+  }
+};
+#endif
+
+} // namespace scope
+
+#endif // SCOPE_ARRAY_HPP_INCLUDE
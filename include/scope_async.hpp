@@ -0,0 +1,228 @@
+#ifndef SCOPE_ASYNC_HPP_INCLUDE
+#define SCOPE_ASYNC_HPP_INCLUDE
+
+#include "scope_any.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace scope {
+
+// what cleanup_executor::post does when the queue is full
+enum class backpressure {
+  block,      // wait until a worker takes a cleanup from the queue
+  run_inline, // run the cleanup on the posting thread
+  drop,       // discard the cleanup without running it, see dropped()
+};
+
+// A fixed number of worker threads running cleanups from a bounded queue.
+// Cleanups of up to inline_size bytes which are nothrow move constructible
+// are queued without allocating. The destructor runs the cleanups still
+// queued before joining the workers.
+//
+// An exception escaping from a cleanup run by a worker terminates the program.
+class cleanup_executor {
+public:
+  static constexpr std::size_t inline_size = 4 * sizeof(void *);
+
+private:
+  using task = detail::_inline_function<inline_size>;
+
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::condition_variable idle_;
+  std::vector<task> queue_; // ring buffer of capacity queue_.size()
+  std::size_t head_{0};
+  std::size_t size_{0};
+  std::size_t busy_{0}; // workers running a cleanup
+  bool stopping_{false};
+  backpressure policy_;
+  std::atomic<std::size_t> dropped_{0};
+  std::vector<std::thread> workers_;
+
+  void _work() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      not_empty_.wait(lock, [this] { return size_ != 0 || stopping_; });
+      if (size_ == 0)
+        return;
+      task t = std::move(queue_[head_]);
+      head_  = (head_ + 1) % queue_.size();
+      --size_;
+      ++busy_;
+      lock.unlock();
+      not_full_.notify_one();
+      t();
+      t.reset();
+      lock.lock();
+      if (--busy_ == 0 && size_ == 0)
+        idle_.notify_all();
+    }
+  }
+
+  void _stop() noexcept {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    not_empty_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+  }
+
+  void _enqueue(task t) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (size_ == queue_.size()) {
+      switch (policy_) {
+      case backpressure::block:
+        not_full_.wait(lock, [this] { return size_ != queue_.size(); });
+        break;
+      case backpressure::run_inline:
+        lock.unlock();
+        t();
+        return;
+      case backpressure::drop:
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+    queue_[(head_ + size_) % queue_.size()] = std::move(t);
+    ++size_;
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+
+public:
+  // Requires: capacity > 0 and threads > 0
+  explicit cleanup_executor(std::size_t capacity = 1024,
+                            std::size_t threads  = 1,
+                            backpressure policy  = backpressure::block)
+      : queue_(capacity)
+      , policy_{policy} {
+    auto stop = detail::_quiet_fail([this] { _stop(); });
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { _work(); });
+    }
+  }
+  cleanup_executor(cleanup_executor const &)            = delete;
+  cleanup_executor &operator=(cleanup_executor const &) = delete;
+  ~cleanup_executor() {
+    _stop();
+  }
+
+  // Queues f to be run by a worker, subject to the backpressure policy. If f
+  // can not be queued because storing it fails, it is run on the calling
+  // thread. To keep f intact for that, it is copied if moving it can throw.
+  template <typename F>
+  void post(F &&f) {
+    using Fn = std::decay_t<F>;
+    static_assert(std::is_invocable_v<Fn &>, "cleanup must be callable");
+    task t;
+    if constexpr (std::is_nothrow_constructible_v<Fn, F> && task::template stores_inline<Fn>) {
+      t.template emplace<Fn>(std::forward<F>(f));
+    } else {
+      SCOPE_TRY {
+        t.template emplace<Fn>(detail::_forward_keeping<Fn, F>(f));
+      } SCOPE_CATCH_ALL {
+        f();
+        return;
+      }
+    }
+    _enqueue(std::move(t));
+  }
+
+  // blocks until all the cleanups queued so far have been run
+  void drain() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    idle_.wait(lock, [this] { return size_ == 0 && busy_ == 0; });
+  }
+
+  // the number of cleanups discarded by backpressure::drop
+  std::size_t dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+};
+
+namespace detail {
+// The exit function of an asynchronous scope guard, it posts the actual exit
+// function to the executor. If copying the latter into the guard fails, it
+// is invoked right away as Policy decides.
+template <typename EF, typename Policy>
+class _post {
+  cleanup_executor *executor_;
+  _box<EF> exit_function_;
+
+  template <typename EFP>
+  static auto _make_failsafe(EFP &ef) {
+    if constexpr (std::is_nothrow_constructible_v<EF, EFP>)
+      return _empty_scope_exit{};
+    else
+      return basic_scope_exit<std::remove_reference_t<EFP> &, _quiet<Policy>>(ef);
+  }
+
+public:
+  template <typename EFP>
+  _post(cleanup_executor &executor, EFP &&ef)
+      : executor_{&executor}
+      , exit_function_(std::forward<EFP>(ef), _make_failsafe(ef)) {}
+
+  void operator()() {
+    executor_->post(exit_function_.move());
+  }
+};
+} // namespace detail
+
+// Scope guards that hand their exit function to a cleanup_executor instead of
+// running it. Whether it is posted is decided when the guard is destroyed,
+// by the same policies as for scope_exit, scope_fail, and scope_success.
+//
+//   scope::scope_exit_async unlink_later{executor, [path] { std::filesystem::remove(path); }};
+template <class EF>
+struct [[nodiscard]] scope_exit_async
+    : basic_scope_exit<detail::_post<EF, detail::on_exit_policy>, detail::on_exit_policy> {
+  template <typename EFP>
+  scope_exit_async(cleanup_executor &executor, EFP &&ef)
+      : basic_scope_exit<detail::_post<EF, detail::on_exit_policy>, detail::on_exit_policy>(
+          detail::_post<EF, detail::on_exit_policy>(executor, std::forward<EFP>(ef))) {}
+};
+
+template <class EF>
+scope_exit_async(cleanup_executor &, EF) -> scope_exit_async<EF>;
+
+template <class EF>
+struct [[nodiscard]] scope_fail_async
+    : basic_scope_exit<detail::_post<EF, detail::on_fail_policy>, detail::on_fail_policy> {
+  template <typename EFP>
+  scope_fail_async(cleanup_executor &executor, EFP &&ef)
+      : basic_scope_exit<detail::_post<EF, detail::on_fail_policy>, detail::on_fail_policy>(
+          detail::_post<EF, detail::on_fail_policy>(executor, std::forward<EFP>(ef))) {}
+};
+
+template <class EF>
+scope_fail_async(cleanup_executor &, EF) -> scope_fail_async<EF>;
+
+template <class EF>
+struct [[nodiscard]] scope_success_async
+    : basic_scope_exit<detail::_post<EF, detail::on_success_policy>, detail::on_success_policy> {
+  template <typename EFP>
+  scope_success_async(cleanup_executor &executor, EFP &&ef)
+      : basic_scope_exit<detail::_post<EF, detail::on_success_policy>, detail::on_success_policy>(
+          detail::_post<EF, detail::on_success_policy>(executor, std::forward<EFP>(ef))) {}
+};
+
+template <class EF>
+scope_success_async(cleanup_executor &, EF) -> scope_success_async<EF>;
+
+} // namespace scope
+
+#endif // SCOPE_ASYNC_HPP_INCLUDE
@@ -0,0 +1,396 @@
+#ifndef SCOPE_CORO_HPP_INCLUDE
+#define SCOPE_CORO_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "scope_coro.hpp requires C++20 coroutines"
+#endif
+#if SCOPE_NO_EXCEPTIONS
+#error "scope_coro.hpp requires exception support"
+#endif
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace scope {
+namespace detail {
+template <typename T>
+struct _co_promise;
+struct _co_promise_base;
+} // namespace detail
+
+// A lazily started coroutine that is awaited by another one, e.g. by the
+// coroutine it was called from. Cleanups registered in it with
+// co_scope_exit, co_scope_fail, and co_scope_success are awaited when its body
+// is left, before the awaiting coroutine is resumed.
+template <typename T = void>
+class [[nodiscard]] co_task {
+  static_assert(!std::is_reference_v<T>, "co_task can not return a reference");
+
+public:
+  using promise_type = detail::_co_promise<T>;
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+
+  friend struct detail::_co_promise_base;
+
+  struct awaiter {
+    std::coroutine_handle<promise_type> handle;
+
+    bool await_ready() const noexcept {
+      return handle.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      handle.promise().continuation_ = awaiting;
+      return handle;
+    }
+    T await_resume() {
+      return handle.promise().result();
+    }
+  };
+
+public:
+  explicit co_task(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_{handle} {}
+  co_task(co_task &&that) noexcept
+      : handle_{std::exchange(that.handle_, nullptr)} {}
+  co_task &operator=(co_task &&that) noexcept {
+    if (&that != this) {
+      if (handle_)
+        handle_.destroy();
+      handle_ = std::exchange(that.handle_, nullptr);
+    }
+    return *this;
+  }
+  ~co_task() {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  // Requires: the task has not been awaited before
+  awaiter operator co_await() && noexcept {
+    return awaiter{handle_};
+  }
+};
+
+namespace detail {
+enum class _co_when { exit, fail, success };
+
+struct _co_cleanup {
+  co_task<void> task;
+  _co_when when;
+  bool released;
+};
+
+// passed to a coroutine to start it right away instead of lazily
+struct _co_eager {};
+
+struct _co_promise_base {
+  std::coroutine_handle<> continuation_{std::noop_coroutine()};
+  std::exception_ptr exception_;
+  std::vector<_co_cleanup> cleanups_;
+  // created with the first cleanup, so leaving the body does not allocate
+  std::optional<co_task<void>> unwind_;
+  bool eager_{false};
+
+  _co_promise_base() noexcept = default;
+  template <typename... Args>
+  explicit _co_promise_base(_co_eager, Args &...) noexcept
+      : eager_{true} {}
+
+  struct initial_awaiter {
+    bool eager;
+
+    bool await_ready() const noexcept {
+      return eager;
+    }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    void await_resume() const noexcept {}
+  };
+  struct final_awaiter {
+    bool await_ready() const noexcept {
+      return false;
+    }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> self) const noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  initial_awaiter initial_suspend() const noexcept {
+    return {eager_};
+  }
+  final_awaiter final_suspend() const noexcept {
+    return {};
+  }
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+};
+
+template <typename T>
+struct _co_promise : _co_promise_base {
+  std::optional<T> value_;
+
+  using _co_promise_base::_co_promise_base;
+
+  co_task<T> get_return_object() noexcept {
+    return co_task<T>{std::coroutine_handle<_co_promise>::from_promise(*this)};
+  }
+  template <typename V>
+  void return_value(V &&v) {
+    value_.emplace(std::forward<V>(v));
+  }
+  T result() {
+    if (exception_)
+      std::rethrow_exception(exception_);
+    return std::move(*value_);
+  }
+};
+
+template <>
+struct _co_promise<void> : _co_promise_base {
+  using _co_promise_base::_co_promise_base;
+
+  co_task<void> get_return_object() noexcept {
+    return co_task<void>{std::coroutine_handle<_co_promise>::from_promise(*this)};
+  }
+  void return_void() noexcept {}
+  void result() {
+    if (exception_)
+      std::rethrow_exception(exception_);
+  }
+};
+
+// Awaits the cleanups of p in reverse order of their registration. It is
+// started when the body of p's coroutine is left, so the outcome of the body
+// is known. The first exception is kept, from the body or from a cleanup.
+inline co_task<void> _co_unwind(_co_promise_base &p) {
+  bool const failed = p.exception_ != nullptr;
+  while (!p.cleanups_.empty()) {
+    auto cleanup = std::move(p.cleanups_.back());
+    p.cleanups_.pop_back();
+    if (cleanup.released || (cleanup.when == _co_when::fail && !failed)
+        || (cleanup.when == _co_when::success && failed))
+      continue;
+    try {
+      co_await std::move(cleanup.task);
+    } catch (...) {
+      if (!p.exception_)
+        p.exception_ = std::current_exception();
+    }
+  }
+}
+
+template <typename P>
+std::coroutine_handle<> _co_promise_base::final_awaiter::await_suspend(std::coroutine_handle<P> self) const noexcept {
+  auto &p = self.promise();
+  if (!p.unwind_)
+    return p.continuation_;
+  // the unwinding task resumes the continuation when it is done
+  auto unwind                    = p.unwind_->handle_;
+  unwind.promise().continuation_ = p.continuation_;
+  return unwind;
+}
+
+// Stores f in a coroutine frame that is suspended until the cleanup is
+// awaited. It is started eagerly, so f is only moved from once its frame has
+// been allocated.
+template <typename F>
+co_task<void> _co_run(_co_eager, F &f) {
+  F fn = std::move(f);
+  co_await std::suspend_always{};
+  if constexpr (std::is_void_v<std::invoke_result_t<F &>>)
+    fn();
+  else
+    co_await fn();
+}
+
+template <typename F>
+class _co_register {
+  static_assert(std::is_nothrow_move_constructible_v<F>, "cleanup must be nothrow move constructible");
+
+  F f_;
+  _co_when when_;
+  _co_promise_base *promise_{nullptr};
+  std::size_t index_{0};
+
+public:
+  template <typename FF>
+  _co_register(FF &&f, _co_when when)
+      : f_(std::forward<FF>(f))
+      , when_{when} {}
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+  // Registers the cleanup without suspending. If that fails, a cleanup
+  // returning void is invoked unless it only runs on success.
+  template <typename P>
+  bool await_suspend(std::coroutine_handle<P> self) {
+    static_assert(std::is_base_of_v<_co_promise_base, P>, "cleanups can only be registered in a co_task");
+    auto &p = self.promise();
+    try {
+      if (!p.unwind_)
+        p.unwind_.emplace(_co_unwind(p));
+      if (p.cleanups_.size() == p.cleanups_.capacity())
+        p.cleanups_.reserve(2 * p.cleanups_.size() + 4);
+      p.cleanups_.push_back(_co_cleanup{_co_run(_co_eager{}, f_), when_, false});
+    } catch (...) {
+      if constexpr (std::is_void_v<std::invoke_result_t<F &>>) {
+        if (when_ != _co_when::success)
+          f_();
+      }
+      throw;
+    }
+    promise_ = &p;
+    index_   = p.cleanups_.size() - 1;
+    return false;
+  }
+  auto await_resume() const noexcept;
+};
+} // namespace detail
+
+// Refers to a cleanup registered in a co_task, which is not run if release()
+// is called while the body of the co_task is being executed.
+class co_cleanup {
+  detail::_co_promise_base *promise_;
+  std::size_t index_;
+
+public:
+  co_cleanup(detail::_co_promise_base *promise, std::size_t index) noexcept
+      : promise_{promise}
+      , index_{index} {}
+
+  void release() noexcept {
+    promise_->cleanups_[index_].released = true;
+  }
+};
+
+template <typename F>
+auto detail::_co_register<F>::await_resume() const noexcept {
+  return co_cleanup{promise_, index_};
+}
+
+// Registers a cleanup in the co_task awaiting the result. It is run after the
+// body of the co_task is left, in any case for co_scope_exit, if the body
+// exits with an exception for co_scope_fail, and otherwise for
+// co_scope_success. Unlike scope_fail and scope_success, this does not depend
+// on std::uncaught_exceptions(), which does not tell anything about a
+// coroutine that is suspended and resumed on another thread.
+//
+// The cleanup may return an awaitable, e.g. a co_task<void>, which is
+// co_awaited then:
+//
+//   co_task<void> send(connection &c, message m) {
+//     co_await scope::co_scope_fail([&c] { return c.async_close(); });
+//     co_await c.async_write(m);
+//   }
+template <typename F>
+[[nodiscard]] auto co_scope_exit(F &&f) {
+  return detail::_co_register<std::decay_t<F>>(std::forward<F>(f), detail::_co_when::exit);
+}
+template <typename F>
+[[nodiscard]] auto co_scope_fail(F &&f) {
+  return detail::_co_register<std::decay_t<F>>(std::forward<F>(f), detail::_co_when::fail);
+}
+template <typename F>
+[[nodiscard]] auto co_scope_success(F &&f) {
+  return detail::_co_register<std::decay_t<F>>(std::forward<F>(f), detail::_co_when::success);
+}
+
+namespace detail {
+template <typename T>
+struct _co_sync_state {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done{false};
+  std::exception_ptr exception;
+  std::optional<T> value;
+};
+template <>
+struct _co_sync_state<void> {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done{false};
+  std::exception_ptr exception;
+};
+
+// The coroutine sync_wait blocks on. It signals completion after it is
+// suspended for the last time, so it can be destroyed right away.
+template <typename T>
+struct _co_sync_task {
+  struct promise_type {
+    _co_sync_state<T> *state;
+
+    promise_type(co_task<T> &, _co_sync_state<T> &s) noexcept
+        : state{&s} {}
+
+    _co_sync_task get_return_object() noexcept {
+      return {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() const noexcept {
+      return {};
+    }
+    auto final_suspend() const noexcept {
+      struct notify {
+        bool await_ready() const noexcept {
+          return false;
+        }
+        void await_suspend(std::coroutine_handle<promise_type> self) const noexcept {
+          auto *state = self.promise().state;
+          std::lock_guard<std::mutex> lock{state->mutex};
+          state->done = true;
+          state->cv.notify_one();
+        }
+        void await_resume() const noexcept {}
+      };
+      return notify{};
+    }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+      state->exception = std::current_exception();
+    }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+_co_sync_task<T> _co_sync(co_task<T> &task, _co_sync_state<T> &state) {
+  if constexpr (std::is_void_v<T>)
+    co_await std::move(task);
+  else
+    state.value.emplace(co_await std::move(task));
+}
+} // namespace detail
+
+// Runs task on the calling thread until it suspends, then blocks until it is
+// completed, and returns its result or rethrows its exception.
+template <typename T>
+T sync_wait(co_task<T> task) {
+  detail::_co_sync_state<T> state{};
+  auto sync = detail::_co_sync(task, state);
+  sync.handle.resume();
+  {
+    std::unique_lock<std::mutex> lock{state.mutex};
+    state.cv.wait(lock, [&] { return state.done; });
+  }
+  sync.handle.destroy();
+  if (state.exception)
+    std::rethrow_exception(state.exception);
+  if constexpr (!std::is_void_v<T>)
+    return std::move(*state.value);
+}
+
+} // namespace scope
+
+#endif // SCOPE_CORO_HPP_INCLUDE
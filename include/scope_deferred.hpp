@@ -0,0 +1,122 @@
+#ifndef SCOPE_DEFERRED_HPP_INCLUDE
+#define SCOPE_DEFERRED_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace scope {
+namespace detail {
+
+// The resources released on one thread that are waiting for their deleters.
+// The storage is part of the thread_local object, so adding to the batch never
+// allocates.
+template <typename R, typename D, std::size_t Threshold>
+class _deferred_batch {
+  struct item {
+    R resource;
+    SCOPE_NO_UNIQUE_ADDRESS D deleter;
+  };
+
+  alignas(item) std::byte storage_[Threshold * sizeof(item)];
+  std::size_t size_{0};
+  bool exited_{false};
+
+  item *_at(std::size_t i) noexcept {
+    return std::launder(reinterpret_cast<item *>(storage_) + i);
+  }
+
+  struct flush_at_exit {
+    _deferred_batch &batch;
+    ~flush_at_exit() {
+      batch.flush();
+      batch.exited_ = true;
+    }
+  };
+
+public:
+  // the batch itself is trivially destructible, so it is still usable by
+  // thread_local destructors running after flush_at_exit, which delete right
+  // away then
+  static _deferred_batch &local() noexcept {
+    static thread_local _deferred_batch batch;
+    static thread_local flush_at_exit flusher{batch};
+    return batch;
+  }
+
+  void add(R const &r, D const &d) noexcept {
+    if (exited_) {
+      d(r);
+      return;
+    }
+    ::new (static_cast<void *>(_at(size_))) item{r, d};
+    if (++size_ == Threshold)
+      flush();
+  }
+
+  // newest first, resources released by the deleters while flushing are
+  // deleted as well
+  void flush() noexcept {
+    while (size_ != 0) {
+      auto *last = _at(--size_);
+      item const it{std::move(*last)};
+      last->~item();
+      it.deleter(it.resource);
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return size_;
+  }
+};
+} // namespace detail
+
+// A deleter adaptor that takes deleting resources off the path releasing
+// them. Instead of calling D, it adds the resource to a batch of the calling
+// thread, which is deleted when it holds Threshold resources, when flush() is
+// called on that thread, and when the thread exits.
+//
+//   using buffer = scope::unique_resource<char *, scope::deferred_deleter<char *, free_buffer>>;
+template <typename R, typename D, std::size_t Threshold = 64>
+class deferred_deleter {
+  static_assert(Threshold > 0, "the batch can not be empty");
+  static_assert(std::is_nothrow_copy_constructible_v<R> && std::is_nothrow_move_constructible_v<R>,
+                "resource must be nothrow copy and move constructible");
+  static_assert(std::is_nothrow_copy_constructible_v<D> && std::is_nothrow_move_constructible_v<D>,
+                "deleter must be nothrow copy and move constructible");
+  static_assert(std::is_nothrow_invocable_v<D const &, R const &>, "deleter must not throw");
+
+  using batch = detail::_deferred_batch<R, D, Threshold>;
+
+  SCOPE_NO_UNIQUE_ADDRESS D deleter_;
+
+public:
+  deferred_deleter() = default;
+  explicit deferred_deleter(D d) noexcept
+      : deleter_(std::move(d)) {}
+
+  void operator()(R const &r) const noexcept {
+    batch::local().add(r, deleter_);
+  }
+
+  // deletes the resources released by the calling thread so far
+  static void flush() noexcept {
+    batch::local().flush();
+  }
+  // the number of resources released by the calling thread that are not
+  // deleted yet
+  static std::size_t pending() noexcept {
+    return batch::local().size();
+  }
+
+  D const &get_deleter() const noexcept {
+    return deleter_;
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_DEFERRED_HPP_INCLUDE
@@ -0,0 +1,327 @@
+#ifndef SCOPE_EPOCH_HPP_INCLUDE
+#define SCOPE_EPOCH_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __COUNTER__
+#define SCOPE_EPOCH(domain) auto SCOPE_CONCAT(scope_, __COUNTER__) = (domain).pin()
+#else
+#define SCOPE_EPOCH(domain) auto SCOPE_CONCAT(scope_, __LINE__) = (domain).pin()
+#endif
+
+namespace scope {
+namespace detail {
+
+struct _retired {
+  _retired *next;
+  void (*reclaim)(_retired *) noexcept;
+};
+
+template <typename R, typename D>
+struct _retired_resource final : _retired {
+  R resource;
+  SCOPE_NO_UNIQUE_ADDRESS D deleter;
+
+  _retired_resource(R const &r, D const &d) noexcept
+      : _retired{nullptr, &_reclaim}
+      , resource(r)
+      , deleter(d) {}
+
+  static void _reclaim(_retired *self) noexcept {
+    auto *retired = static_cast<_retired_resource *>(self);
+    retired->deleter(retired->resource);
+    delete retired;
+  }
+};
+
+inline void _reclaim_all(_retired *list) noexcept {
+  while (list) {
+    auto *next = std::exchange(list->next, nullptr);
+    list->reclaim(list);
+    list = next;
+  }
+}
+
+// The state of one thread in one epoch_domain. It is shared by the domain and
+// the thread using it and deleted by the last of them to let go.
+struct _epoch_record {
+  // the epoch observed when the outermost read section was entered, shifted
+  // left by one, the lowest bit is set while in a read section
+  std::atomic<std::uint64_t> state{0};
+  std::atomic<bool> in_use{true};
+  std::atomic<bool> orphaned{false};
+  std::atomic<int> references{2};
+  _epoch_record *next{nullptr};
+
+  // only accessed by the thread using the record
+  unsigned nesting{0};
+  std::size_t retired{0};
+  struct bag {
+    _retired *head{nullptr};
+    std::uint64_t epoch{0};
+  } bags[3];
+
+  void unreference() noexcept {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+};
+
+// The records of the calling thread, keyed by a domain id that is never
+// reused, so the records of destroyed domains are never found.
+class _epoch_thread {
+  struct entry {
+    std::uint64_t domain;
+    _epoch_record *record;
+  };
+  std::vector<entry> entries_;
+
+  static void _release(_epoch_record *record) noexcept {
+    record->in_use.store(false, std::memory_order_release);
+    record->unreference();
+  }
+
+public:
+  ~_epoch_thread() {
+    for (auto const &e : entries_) {
+      _release(e.record);
+    }
+  }
+
+  static _epoch_thread &local() noexcept {
+    static thread_local _epoch_thread thread;
+    return thread;
+  }
+
+  _epoch_record *find(std::uint64_t domain) const noexcept {
+    for (auto const &e : entries_) {
+      if (e.domain == domain)
+        return e.record;
+    }
+    return nullptr;
+  }
+  void add(std::uint64_t domain, _epoch_record *record) {
+    auto stale = _quiet_fail([record] { _release(record); });
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->record->orphaned.load(std::memory_order_acquire)) {
+        _release(it->record);
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    entries_.push_back(entry{domain, record});
+  }
+};
+
+struct _epoch_unpin {
+  _epoch_record *record;
+
+  void operator()() const noexcept {
+    if (--record->nesting == 0)
+      record->state.store(0, std::memory_order_release);
+  }
+};
+} // namespace detail
+
+// Epoch based reclamation: resources retired to a domain are deleted only
+// when no thread can still be reading them. Readers enter a read section with
+// pin() or SCOPE_EPOCH(domain) before they load pointers from a shared data
+// structure and keep using them until the guard is destroyed. A writer unlinks
+// a node and retires it, e.g. through a unique_resource with an epoch_deleter.
+// The node is deleted once every thread that was in a read section when it
+// was retired has left it.
+//
+//   scope::epoch_domain domain;
+//
+//   { // reader
+//     SCOPE_EPOCH(domain);
+//     for (auto *n = head.load(); n; n = n->next.load()) { ... }
+//   }
+//   { // writer
+//     auto *n = unlink(key);
+//     domain.retire(n, std::default_delete<node>{});
+//   }
+//
+// A domain must outlive its read sections and retire() calls. The resources
+// still retired when it is destroyed are deleted then.
+class epoch_domain {
+  std::atomic<std::uint64_t> epoch_{0};
+  std::atomic<detail::_epoch_record *> records_{nullptr};
+  std::uint64_t const id_;
+  std::size_t const threshold_;
+
+  static std::uint64_t _next_id() noexcept {
+    static std::atomic<std::uint64_t> ids{0};
+    return ids.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  detail::_epoch_record *_acquire_record() {
+    for (auto *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+      bool idle = false;
+      if (!r->in_use.load(std::memory_order_relaxed)
+          && r->in_use.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+        r->references.fetch_add(1, std::memory_order_relaxed);
+        return r;
+      }
+    }
+    auto *r = new detail::_epoch_record{};
+    r->next = records_.load(std::memory_order_relaxed);
+    while (!records_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    return r;
+  }
+
+  detail::_epoch_record &_local() {
+    auto &thread = detail::_epoch_thread::local();
+    if (auto *r = thread.find(id_))
+      return *r;
+    auto *r = _acquire_record();
+    thread.add(id_, r);
+    return *r;
+  }
+
+  // deletes the bags of r that no reader can see anymore
+  void _collect(detail::_epoch_record &r, std::uint64_t epoch) noexcept {
+    for (auto &bag : r.bags) {
+      if (bag.head && bag.epoch + 2 <= epoch)
+        detail::_reclaim_all(std::exchange(bag.head, nullptr));
+    }
+  }
+
+  void _retire(detail::_epoch_record &r, detail::_retired *node) noexcept {
+    auto const epoch = epoch_.load(std::memory_order_seq_cst);
+    auto &bag        = r.bags[epoch % 3];
+    if (bag.epoch != epoch) {
+      // the bag holds resources retired three or more epochs ago
+      detail::_reclaim_all(std::exchange(bag.head, nullptr));
+      bag.epoch = epoch;
+    }
+    node->next = bag.head;
+    bag.head   = node;
+    if (++r.retired >= threshold_) {
+      r.retired = 0;
+      try_advance();
+      _collect(r, epoch_.load(std::memory_order_seq_cst));
+    }
+  }
+
+public:
+  // Requires: threshold > 0, the number of resources a thread retires before
+  // it tries to advance the epoch
+  explicit epoch_domain(std::size_t threshold = 64) noexcept
+      : id_{_next_id()}
+      , threshold_{threshold} {}
+  epoch_domain(epoch_domain const &)            = delete;
+  epoch_domain &operator=(epoch_domain const &) = delete;
+  ~epoch_domain() {
+    auto *r = records_.load(std::memory_order_acquire);
+    while (r) {
+      auto *next = r->next;
+      for (auto &bag : r->bags) {
+        detail::_reclaim_all(std::exchange(bag.head, nullptr));
+      }
+      r->orphaned.store(true, std::memory_order_release);
+      r->unreference();
+      r = next;
+    }
+  }
+
+  // Enters a read section of the calling thread, which lasts until the
+  // returned guard is destroyed. Read sections can be nested.
+  [[nodiscard]] scope_exit<detail::_epoch_unpin> pin() {
+    auto &r = _local();
+    if (r.nesting++ == 0) {
+      r.state.store(epoch_.load(std::memory_order_relaxed) << 1 | 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    return scope_exit<detail::_epoch_unpin>(detail::_epoch_unpin{&r});
+  }
+
+  // Hands r over to the domain, which calls d(r) when no read section that
+  // could see r is left. If memory for that is exhausted, it waits for the
+  // read sections and deletes r right away, which the calling thread must
+  // not be in a read section for.
+  template <typename R, typename D>
+  void retire(R const &r, D const &d) noexcept {
+    static_assert(std::is_nothrow_copy_constructible_v<R> && std::is_nothrow_copy_constructible_v<D>,
+                  "retired resources and their deleters must be nothrow copy constructible");
+    static_assert(std::is_nothrow_invocable_v<D &, R &>, "deleter must not throw");
+    detail::_epoch_record *record = nullptr;
+    SCOPE_TRY {
+      record = &_local();
+    } SCOPE_CATCH_ALL {
+    }
+    auto *node = record ? new (std::nothrow) detail::_retired_resource<R, D>(r, d) : nullptr;
+    if (node) {
+      _retire(*record, node);
+    } else {
+      synchronize();
+      D deleter{d};
+      R resource{r};
+      deleter(resource);
+    }
+  }
+
+  // Advances the epoch if every thread in a read section has observed the
+  // current one, returns whether it did.
+  bool try_advance() noexcept {
+    auto epoch = epoch_.load(std::memory_order_seq_cst);
+    for (auto *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+      auto const state = r->state.load(std::memory_order_seq_cst);
+      if ((state & 1) && (state >> 1) != epoch)
+        return false;
+    }
+    return epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+  }
+
+  // Deletes the resources retired by the calling thread that no reader can
+  // see anymore.
+  void collect() {
+    try_advance();
+    _collect(_local(), epoch_.load(std::memory_order_seq_cst));
+  }
+
+  // Waits until all the read sections that are active now have been left.
+  // Requires: the calling thread is not in a read section
+  void synchronize() noexcept {
+    auto const target = epoch_.load(std::memory_order_seq_cst) + 2;
+    while (epoch_.load(std::memory_order_seq_cst) < target) {
+      if (!try_advance())
+        std::this_thread::yield();
+    }
+  }
+};
+
+inline epoch_domain &default_epoch_domain() noexcept {
+  static epoch_domain domain;
+  return domain;
+}
+
+// A deleter that retires resources to an epoch_domain instead of deleting
+// them right away, so they can be owned by a unique_resource.
+//
+//   scope::unique_resource<node *, scope::epoch_deleter<std::default_delete<node>>> old{unlink(key), {}};
+template <typename D>
+struct epoch_deleter {
+  epoch_domain *domain{&default_epoch_domain()};
+  SCOPE_NO_UNIQUE_ADDRESS D deleter{};
+
+  template <typename R>
+  void operator()(R const &r) const noexcept {
+    domain->retire(r, deleter);
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_EPOCH_HPP_INCLUDE
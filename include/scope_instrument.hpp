@@ -0,0 +1,200 @@
+#ifndef SCOPE_INSTRUMENT_HPP_INCLUDE
+#define SCOPE_INSTRUMENT_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#if !SCOPE_INSTRUMENTATION
+#error "scope_instrument.hpp requires SCOPE_INSTRUMENTATION to be defined to 1"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace scope {
+namespace detail {
+
+// bucket b counts durations of less than 2^b nanoseconds that don't fit
+// bucket b - 1
+inline constexpr std::size_t _latency_buckets = 64;
+
+inline std::size_t _latency_bucket(std::uint64_t nanoseconds) noexcept {
+  std::size_t bucket = 0;
+  while (nanoseconds != 0 && bucket + 1 < _latency_buckets) {
+    nanoseconds >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+// The counters of one site on one thread. Only that thread writes them, so
+// they are plain loads and stores, the atomics are for the readers.
+struct _site_counters {
+  scope_site *site;
+  _site_counters *next;
+  std::atomic<std::uint64_t> events[scope_event_count]{};
+  std::atomic<std::uint64_t> latency[_latency_buckets]{};
+  std::atomic<std::uint64_t> nanoseconds{0};
+
+  static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t by = 1) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+};
+
+// The counters of a thread. When the thread exits, they are adopted by the
+// next thread starting to report events, so their number is bounded by the
+// number of threads running at the same time.
+struct _thread_counters {
+  std::atomic<_site_counters *> sites{nullptr};
+  std::atomic<bool> in_use{true};
+  _thread_counters *next{nullptr};
+  // indexed by scope_site_index(), only accessed by the owning thread
+  std::vector<_site_counters *> by_index;
+
+  static inline std::atomic<_thread_counters *> all{nullptr};
+
+  static _thread_counters *_acquire() noexcept {
+    for (auto *t = all.load(std::memory_order_acquire); t; t = t->next) {
+      bool idle = false;
+      if (!t->in_use.load(std::memory_order_relaxed)
+          && t->in_use.compare_exchange_strong(idle, true, std::memory_order_acquire))
+        return t;
+    }
+    auto *t = new (std::nothrow) _thread_counters{};
+    if (t) {
+      t->next = all.load(std::memory_order_relaxed);
+      while (!all.compare_exchange_weak(t->next, t, std::memory_order_release, std::memory_order_relaxed)) {
+      }
+    }
+    return t;
+  }
+
+  // Once the counters are handed back, the events reported by the thread_local
+  // objects of the thread destroyed after its owner are dropped, since the
+  // counters may be in use by another thread already.
+  struct owner {
+    _thread_counters *counters{_acquire()};
+    ~owner() {
+      if (auto *released = std::exchange(counters, nullptr))
+        released->in_use.store(false, std::memory_order_release);
+    }
+  };
+
+  // nullptr if the counters could not be allocated or were handed back
+  static _thread_counters *local() noexcept {
+    static thread_local owner thread;
+    return thread.counters;
+  }
+
+  _site_counters *find(scope_site &site) noexcept {
+    auto const index = scope_site_index(site);
+    if (index < by_index.size() && by_index[index])
+      return by_index[index];
+    auto *counters = new (std::nothrow) _site_counters{&site, sites.load(std::memory_order_relaxed)};
+    if (!counters)
+      return nullptr;
+    SCOPE_TRY {
+      if (by_index.size() <= index)
+        by_index.resize(index + 1);
+    } SCOPE_CATCH_ALL {
+      delete counters;
+      return nullptr;
+    }
+    by_index[index] = counters;
+    sites.store(counters, std::memory_order_release);
+    return counters;
+  }
+};
+} // namespace detail
+
+// The default sink: counts the events and keeps histograms of the time taken
+// by exit functions and deleters, per site and per thread, without locks or
+// read-modify-write operations. snapshot() adds them up over the threads.
+//
+// Events are dropped if memory for the counters of a new site or thread
+// can not be allocated, or if they are reported while a thread exits, after
+// its counters were handed back. The counters are never freed.
+class counting_sink {
+public:
+  struct site_summary {
+    char const *name;
+    std::uint64_t events[scope_event_count];
+    std::uint64_t latency[detail::_latency_buckets];
+    std::uint64_t nanoseconds; // in total
+
+    std::uint64_t count(scope_event event) const noexcept {
+      return events[static_cast<std::size_t>(event)];
+    }
+    // an upper bound of the duration of the given fraction of the exit
+    // functions and deleters, e.g. 0.99 for the 99th percentile
+    std::uint64_t percentile(double fraction) const noexcept {
+      std::uint64_t total = 0;
+      for (auto n : latency) {
+        total += n;
+      }
+      std::uint64_t seen = 0;
+      for (std::size_t bucket = 0; bucket < detail::_latency_buckets; ++bucket) {
+        seen += latency[bucket];
+        if (seen != 0 && static_cast<double>(seen) >= fraction * static_cast<double>(total))
+          return (std::uint64_t{1} << bucket) - 1;
+      }
+      return 0;
+    }
+  };
+
+  static scope_sink install() noexcept {
+    return set_scope_sink(&record);
+  }
+
+  static void record(scope_record const &r) noexcept {
+    auto *thread = detail::_thread_counters::local();
+    if (!thread)
+      return;
+    auto *site = thread->find(*r.site);
+    if (!site)
+      return;
+    detail::_site_counters::bump(site->events[static_cast<std::size_t>(r.event)]);
+    if (r.event == scope_event::deleted || r.event == scope_event::executed_on_exit
+        || r.event == scope_event::executed_on_fail || r.event == scope_event::executed_on_success) {
+      detail::_site_counters::bump(site->latency[detail::_latency_bucket(r.nanoseconds)]);
+      detail::_site_counters::bump(site->nanoseconds, r.nanoseconds);
+    }
+  }
+
+  // the sites that reported events, the ones that took the most time first
+  static std::vector<site_summary> snapshot() {
+    std::vector<site_summary> summaries;
+    std::vector<std::size_t> slot_of; // by site index, 0 for none
+    for (auto *t = detail::_thread_counters::all.load(std::memory_order_acquire); t; t = t->next) {
+      for (auto *c = t->sites.load(std::memory_order_acquire); c; c = c->next) {
+        auto const index = scope_site_index(*c->site);
+        if (slot_of.size() <= index)
+          slot_of.resize(index + 1);
+        if (slot_of[index] == 0) {
+          summaries.push_back(site_summary{c->site->name, {}, {}, 0});
+          slot_of[index] = summaries.size();
+        }
+        auto &summary = summaries[slot_of[index] - 1];
+        for (std::size_t e = 0; e < scope_event_count; ++e) {
+          summary.events[e] += c->events[e].load(std::memory_order_relaxed);
+        }
+        for (std::size_t b = 0; b < detail::_latency_buckets; ++b) {
+          summary.latency[b] += c->latency[b].load(std::memory_order_relaxed);
+        }
+        summary.nanoseconds += c->nanoseconds.load(std::memory_order_relaxed);
+      }
+    }
+    std::sort(summaries.begin(), summaries.end(), [](site_summary const &a, site_summary const &b) {
+      return a.nanoseconds > b.nanoseconds;
+    });
+    return summaries;
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_INSTRUMENT_HPP_INCLUDE
@@ -0,0 +1,197 @@
+#ifndef SCOPE_MAPPING_HPP_INCLUDE
+#define SCOPE_MAPPING_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#if !__has_include(<sys/mman.h>)
+#error "scope_mapping.hpp requires POSIX mmap"
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+namespace scope {
+
+// The deleter of a mapping, it knows the length to unmap.
+struct munmap_deleter {
+  std::size_t length;
+
+  void operator()(void *address) const noexcept {
+    ::munmap(address, length);
+  }
+};
+
+// A mapping that failed holds MAP_FAILED, so a unique_resource constructed
+// from the result of mmap() owns it only if it succeeded. MAP_FAILED is a
+// cast, hence invalid() is not constexpr.
+template <>
+struct resource_traits<void *, munmap_deleter> {
+  static void *invalid() noexcept {
+    return MAP_FAILED;
+  }
+};
+
+// or'ed into the flags to prefault the pages, where the system supports it
+#if defined(MAP_POPULATE)
+inline constexpr int map_populate = MAP_POPULATE;
+#else
+inline constexpr int map_populate = 0;
+#endif
+
+// what the pages of a mapping will be used for, see advise()
+enum class mapping_advice {
+  normal,
+  sequential, // read in order, pages can be read ahead and dropped early
+  random,     // no read ahead
+  willneed,   // read the pages ahead now
+  dontneed,   // the pages can be dropped
+  hugepage,   // back the mapping with transparent huge pages where supported
+};
+
+// Owns a memory mapping and gives views of its bytes. A mapping that could
+// not be created is empty and errno tells why, as for mmap().
+//
+//   auto file = scope::unique_mapping::map_file("input.csv");
+//   file.advise(scope::mapping_advice::sequential);
+//   for (auto line : split(file.view(), '\n')) { ... }
+class unique_mapping {
+  unique_resource<void *, munmap_deleter> mapping_;
+
+  static int _advice(mapping_advice a) noexcept {
+    switch (a) {
+    case mapping_advice::normal:
+      return MADV_NORMAL;
+    case mapping_advice::sequential:
+      return MADV_SEQUENTIAL;
+    case mapping_advice::random:
+      return MADV_RANDOM;
+    case mapping_advice::willneed:
+      return MADV_WILLNEED;
+    case mapping_advice::dontneed:
+      return MADV_DONTNEED;
+    case mapping_advice::hugepage:
+#if defined(MADV_HUGEPAGE)
+      return MADV_HUGEPAGE;
+#else
+      break;
+#endif
+    }
+    return -1;
+  }
+
+public:
+  unique_mapping() noexcept
+      : mapping_{MAP_FAILED, munmap_deleter{0}} {}
+  // takes the ownership of a mapping created with mmap()
+  explicit unique_mapping(unique_resource<void *, munmap_deleter> mapping) noexcept
+      : mapping_{std::move(mapping)} {}
+
+  // Maps length bytes of fd from offset, which must be a multiple of the page
+  // size. fd can be closed afterwards.
+  [[nodiscard]] static unique_mapping
+  map(int fd, std::size_t length, int prot = PROT_READ, int flags = MAP_SHARED, off_t offset = 0) noexcept {
+    return unique_mapping{make_unique_resource_checked(
+        ::mmap(nullptr, length, prot, flags, fd, offset), MAP_FAILED, munmap_deleter{length})};
+  }
+  // Maps a whole file for reading. An empty file can not be mapped.
+  [[nodiscard]] static unique_mapping map_file(char const *path, int flags = MAP_SHARED) noexcept {
+    auto fd = make_unique_resource_checked<&::close>(::open(path, O_RDONLY | O_CLOEXEC), -1);
+    struct stat st {};
+    if (fd.get() == -1 || ::fstat(fd.get(), &st) != 0)
+      return unique_mapping{};
+    return map(fd.get(), static_cast<std::size_t>(st.st_size), PROT_READ, flags);
+  }
+  // Maps length bytes of zeroed memory for reading and writing, flags are
+  // added to MAP_PRIVATE | MAP_ANONYMOUS, e.g. map_populate.
+  [[nodiscard]] static unique_mapping anonymous(std::size_t length, int flags = 0) noexcept {
+    return map(-1, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags);
+  }
+
+  bool mapped() const noexcept {
+    return mapping_.get() != MAP_FAILED;
+  }
+  std::byte *data() const noexcept {
+    return mapped() ? static_cast<std::byte *>(mapping_.get()) : nullptr;
+  }
+  std::size_t size() const noexcept {
+    return mapped() ? mapping_.get_deleter().length : 0;
+  }
+  std::byte *begin() const noexcept {
+    return data();
+  }
+  std::byte *end() const noexcept {
+    return data() + size();
+  }
+  // the mapped bytes as characters, valid as long as the mapping
+  std::string_view view() const noexcept {
+    return {reinterpret_cast<char const *>(data()), size()};
+  }
+#if defined(__cpp_lib_span)
+  std::span<std::byte> bytes() const noexcept {
+    return {data(), size()};
+  }
+#endif
+
+  // Tells the system how the pages overlapping [offset, offset + length)
+  // will be used, the whole mapping by default. Returns false and sets errno
+  // if the advice is not supported or taken.
+  bool advise(mapping_advice a, std::size_t offset = 0, std::size_t length = std::size_t(-1)) const noexcept {
+    auto const advice = _advice(a);
+    if (advice == -1 || !mapped() || offset > size()) {
+      errno = advice == -1 ? ENOTSUP : EINVAL;
+      return false;
+    }
+    if (length > size() - offset)
+      length = size() - offset;
+    auto const page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto const skew = offset % page;
+    return ::madvise(data() + offset - skew, length + skew, advice) == 0;
+  }
+
+  // Grows or shrinks the mapping, it may be moved then. Returns false and
+  // sets errno if that fails, the mapping is unchanged then. Requires Linux
+  // mremap(), the mapping can not be resized elsewhere.
+  bool remap(std::size_t length) noexcept {
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+    if (!mapped()) {
+      errno = EINVAL;
+      return false;
+    }
+    auto *address = ::mremap(mapping_.get(), size(), length, MREMAP_MAYMOVE);
+    if (address == MAP_FAILED)
+      return false;
+    // the old mapping is gone, it must not be unmapped
+    mapping_.release();
+    mapping_ = unique_resource<void *, munmap_deleter>{address, munmap_deleter{length}};
+    return true;
+#else
+    (void)length;
+    errno = ENOTSUP;
+    return false;
+#endif
+  }
+
+  void reset() noexcept {
+    mapping_.reset();
+  }
+  // gives up the ownership of the mapping, which stays mapped
+  std::pair<void *, std::size_t> release() noexcept {
+    std::pair<void *, std::size_t> const mapping{data(), size()};
+    mapping_.release();
+    return mapping;
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_MAPPING_HPP_INCLUDE
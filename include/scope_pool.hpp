@@ -0,0 +1,342 @@
+#ifndef SCOPE_POOL_HPP_INCLUDE
+#define SCOPE_POOL_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace scope {
+namespace detail {
+
+// Stored behind each pooled object, it links the idle objects.
+struct _pool_link {
+  _pool_link *next;
+  // for the first object of a batch on the shared stack
+  _pool_link *next_batch;
+  std::size_t count;
+};
+
+// The idle objects of a pool shared by all threads, a lock-free stack of
+// batches. Taking all batches with one exchange instead of popping one avoids
+// the ABA problem. It is shared by the pool and the threads caching its
+// objects and deleted by the last of them to let go.
+struct _pool_shared {
+  std::atomic<_pool_link *> batches{nullptr};
+  std::atomic<std::size_t> idle{0};
+  std::atomic<int> references{1};
+  std::atomic<bool> closed{false};
+  std::size_t const capacity;
+  std::size_t const thread_capacity;
+  void (*const destroy)(_pool_link *) noexcept;
+
+  _pool_shared(std::size_t c, std::size_t tc, void (*d)(_pool_link *) noexcept) noexcept
+      : capacity{c}
+      , thread_capacity{tc}
+      , destroy{d} {}
+
+  void destroy_all(_pool_link *first) const noexcept {
+    while (first) {
+      destroy(std::exchange(first, first->next));
+    }
+  }
+
+  // adds the count objects linked from first, or destroys them if that would
+  // exceed the capacity
+  void push(_pool_link *first, std::size_t count) noexcept {
+    if (idle.fetch_add(count, std::memory_order_relaxed) + count > capacity) {
+      idle.fetch_sub(count, std::memory_order_relaxed);
+      destroy_all(first);
+      return;
+    }
+    first->count      = count;
+    first->next_batch = batches.load(std::memory_order_relaxed);
+    while (!batches.compare_exchange_weak(
+        first->next_batch, first, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+  }
+
+  // takes a batch, count is set to the number of objects in it
+  _pool_link *pop(std::size_t &count) noexcept {
+    auto *first = batches.exchange(nullptr, std::memory_order_acquire);
+    if (!first)
+      return nullptr;
+    if (auto *rest = first->next_batch) {
+      auto *last = rest;
+      while (last->next_batch) {
+        last = last->next_batch;
+      }
+      last->next_batch = batches.load(std::memory_order_relaxed);
+      while (!batches.compare_exchange_weak(
+          last->next_batch, rest, std::memory_order_release, std::memory_order_relaxed)) {
+      }
+    }
+    count = first->count;
+    idle.fetch_sub(count, std::memory_order_relaxed);
+    return first;
+  }
+
+  void drain() noexcept {
+    auto *batch = batches.exchange(nullptr, std::memory_order_acquire);
+    while (batch) {
+      auto *next = batch->next_batch;
+      idle.fetch_sub(batch->count, std::memory_order_relaxed);
+      destroy_all(batch);
+      batch = next;
+    }
+  }
+
+  void unreference() noexcept {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      drain();
+      delete this;
+    }
+  }
+};
+
+// The idle objects cached by the calling thread, per pool. They go back to the
+// shared stack of their pool when the thread exits.
+class _pool_thread {
+  struct entry {
+    _pool_shared *pool;
+    _pool_link *first;
+    std::size_t count;
+  };
+  std::vector<entry> entries_;
+  std::size_t last_{0};
+
+  static bool &_exited() noexcept {
+    static thread_local bool exited{false};
+    return exited;
+  }
+
+  static void _release(entry &e) noexcept {
+    if (e.first && !e.pool->closed.load(std::memory_order_acquire))
+      e.pool->push(e.first, e.count);
+    else
+      e.pool->destroy_all(e.first);
+    e.pool->unreference();
+  }
+
+  entry *_find(_pool_shared &pool) noexcept {
+    if (last_ < entries_.size() && entries_[last_].pool == &pool)
+      return &entries_[last_];
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+      if (entries_[i].pool == &pool) {
+        last_ = i;
+        return &entries_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  entry *_find_or_add(_pool_shared &pool) noexcept {
+    if (auto *e = _find(pool))
+      return e;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->pool->closed.load(std::memory_order_acquire)) {
+        _release(*it);
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    SCOPE_TRY {
+      entries_.push_back(entry{&pool, nullptr, 0});
+    } SCOPE_CATCH_ALL {
+      return nullptr;
+    }
+    pool.references.fetch_add(1, std::memory_order_relaxed);
+    last_ = entries_.size() - 1;
+    return &entries_.back();
+  }
+
+public:
+  ~_pool_thread() {
+    for (auto &e : entries_) {
+      _release(e);
+    }
+    _exited() = true;
+  }
+
+  // nullptr once the cache of the calling thread has been destroyed
+  static _pool_thread *local() noexcept {
+    if (_exited())
+      return nullptr;
+    static thread_local _pool_thread thread;
+    return &thread;
+  }
+
+  _pool_link *take(_pool_shared &pool) noexcept {
+    auto *e = _find(pool);
+    if (!e || !e->first) {
+      std::size_t count = 0;
+      auto *batch       = pool.pop(count);
+      if (!batch)
+        return nullptr;
+      if (!e && !(e = _find_or_add(pool))) {
+        pool.push(batch, count);
+        return nullptr;
+      }
+      e->first = batch;
+      e->count = count;
+    }
+    --e->count;
+    return std::exchange(e->first, e->first->next);
+  }
+
+  // Caches link, if the cache is full, half of it goes to the shared stack.
+  void give(_pool_shared &pool, _pool_link *link) noexcept {
+    auto *e = _find_or_add(pool);
+    if (!e) {
+      link->next = nullptr;
+      pool.push(link, 1);
+      return;
+    }
+    if (e->count >= pool.thread_capacity) {
+      auto const half = (e->count + 1) / 2;
+      auto *first     = e->first;
+      auto *last      = first;
+      for (std::size_t i = 1; i < half; ++i) {
+        last = last->next;
+      }
+      e->first = std::exchange(last->next, nullptr);
+      e->count -= half;
+      pool.push(first, half);
+    }
+    link->next = e->first;
+    e->first   = link;
+    ++e->count;
+  }
+
+  // destroys the objects of pool cached by the calling thread
+  void trim(_pool_shared &pool) noexcept {
+    if (auto *e = _find(pool)) {
+      pool.destroy_all(std::exchange(e->first, nullptr));
+      e->count = 0;
+    }
+  }
+};
+} // namespace detail
+
+template <typename T>
+class object_pool;
+
+// The deleter of the objects of an object_pool, it gives them back to it.
+template <typename T>
+struct recycle_deleter {
+  object_pool<T> *pool;
+
+  void operator()(T *object) const noexcept {
+    pool->_recycle(object);
+  }
+};
+
+template <typename T>
+struct resource_traits<T *, recycle_deleter<T>> {
+  static constexpr T *invalid() noexcept {
+    return nullptr;
+  }
+};
+
+// Recycles objects instead of destroying them, e.g. large I/O buffers. An
+// object acquired from the pool is owned by a unique_resource, which gives it
+// back to the calling thread's cache of the pool when it is released. Only
+// when that cache holds thread_capacity objects, half of them go to a stack
+// shared by all threads, and when that holds capacity objects, further ones
+// are destroyed. acquire() takes an object from the calling thread's cache,
+// otherwise a batch from the shared stack, and constructs a new one if both
+// are empty.
+//
+// Recycled objects are handed out as they were given back. The pool must
+// outlive the objects acquired from it.
+//
+//   scope::object_pool<std::vector<char>> buffers;
+//
+//   auto buffer = buffers.acquire();
+//   buffer->resize(size); // keeps the capacity of earlier requests
+template <typename T>
+class object_pool {
+  static_assert(std::is_object_v<T> && !std::is_array_v<T>, "pooled objects must be complete objects");
+
+  friend struct recycle_deleter<T>;
+
+  static constexpr std::size_t link_offset_ =
+      (sizeof(T) + alignof(detail::_pool_link) - 1) / alignof(detail::_pool_link) * alignof(detail::_pool_link);
+  static constexpr std::size_t size_ = link_offset_ + sizeof(detail::_pool_link);
+  static constexpr std::align_val_t align_{alignof(T) > alignof(detail::_pool_link) ? alignof(T)
+                                                                                     : alignof(detail::_pool_link)};
+
+  detail::_pool_shared *shared_;
+
+  static detail::_pool_link *_link(T *object) noexcept {
+    return std::launder(reinterpret_cast<detail::_pool_link *>(reinterpret_cast<std::byte *>(object) + link_offset_));
+  }
+  static T *_object(detail::_pool_link *link) noexcept {
+    return std::launder(reinterpret_cast<T *>(reinterpret_cast<std::byte *>(link) - link_offset_));
+  }
+  static void _destroy(detail::_pool_link *link) noexcept {
+    auto *object = _object(link);
+    object->~T();
+    ::operator delete(static_cast<void *>(object), align_);
+  }
+
+  void _recycle(T *object) noexcept {
+    if (auto *thread = detail::_pool_thread::local()) {
+      thread->give(*shared_, _link(object));
+    } else {
+      _link(object)->next = nullptr;
+      shared_->push(_link(object), 1);
+    }
+  }
+
+public:
+  using pointer = unique_resource<T *, recycle_deleter<T>>;
+
+  // Requires: thread_capacity > 0
+  explicit object_pool(std::size_t capacity = 1024, std::size_t thread_capacity = 64)
+      : shared_{new detail::_pool_shared{capacity, thread_capacity, &_destroy}} {}
+  object_pool(object_pool const &)            = delete;
+  object_pool &operator=(object_pool const &) = delete;
+  ~object_pool() {
+    shared_->closed.store(true, std::memory_order_release);
+    trim();
+    shared_->unreference();
+  }
+
+  // Returns an idle object, or one constructed from args if there is none.
+  template <typename... Args>
+  [[nodiscard]] pointer acquire(Args &&...args) {
+    auto *thread = detail::_pool_thread::local();
+    if (auto *link = thread ? thread->take(*shared_) : nullptr)
+      return pointer{_object(link), recycle_deleter<T>{this}};
+    auto *storage = ::operator new(size_, align_);
+    {
+      auto guard = detail::_quiet_fail([storage] { ::operator delete(storage, align_); });
+      ::new (storage) T(std::forward<Args>(args)...);
+    }
+    auto *object = std::launder(static_cast<T *>(storage));
+    ::new (static_cast<void *>(reinterpret_cast<std::byte *>(object) + link_offset_)) detail::_pool_link{};
+    return pointer{object, recycle_deleter<T>{this}};
+  }
+
+  // destroys the idle objects of the shared stack and of the calling thread
+  void trim() noexcept {
+    if (auto *thread = detail::_pool_thread::local())
+      thread->trim(*shared_);
+    shared_->drain();
+  }
+
+  // the number of idle objects on the shared stack
+  std::size_t idle() const noexcept {
+    return shared_->idle.load(std::memory_order_relaxed);
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_POOL_HPP_INCLUDE
@@ -0,0 +1,222 @@
+#ifndef SCOPE_REGISTRY_HPP_INCLUDE
+#define SCOPE_REGISTRY_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#if !SCOPE_INSTRUMENTATION
+#error "scope_registry.hpp requires SCOPE_INSTRUMENTATION to be defined to 1"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace scope {
+namespace detail {
+
+inline std::size_t _current_cpu() noexcept {
+#if defined(__linux__)
+  auto const cpu = ::sched_getcpu();
+  if (cpu >= 0)
+    return static_cast<std::size_t>(cpu);
+#endif
+  return std::hash<std::thread::id>{}(std::this_thread::get_id());
+}
+
+// The number of live resources per type on one CPU, in a fixed size open
+// addressing table, so counting takes no lock and no allocation. A resource
+// released on another CPU than the one it was acquired on makes the counts of
+// both CPUs off by one, their sum is right.
+struct alignas(64) _count_shard {
+  static constexpr std::size_t size = 64;
+
+  struct slot {
+    std::atomic<scope_site *> site{nullptr};
+    std::atomic<std::int64_t> live{0};
+  } slots[size];
+
+  std::atomic<std::int64_t> *find(scope_site *site) noexcept {
+    auto const start = std::hash<scope_site *>{}(site);
+    for (std::size_t i = 0; i < size; ++i) {
+      auto &s   = slots[(start + i) % size];
+      auto *now = s.site.load(std::memory_order_acquire);
+      if (now == site)
+        return &s.live;
+      if (!now && s.site.compare_exchange_strong(now, site, std::memory_order_acq_rel))
+        return &s.live;
+      if (now == site)
+        return &s.live;
+    }
+    return nullptr;
+  }
+};
+
+// The tracked resources with a handle hashing to the shard.
+struct alignas(64) _handle_shard {
+  struct held {
+    scope_site *site;
+    scope_location where;
+  };
+  std::mutex mutex;
+  std::unordered_multimap<std::uintptr_t, held> handles;
+};
+} // namespace detail
+
+// An instrumentation sink counting the live unique_resources per type, on 64
+// shards picked by the current CPU. Optionally, it also keeps the handle and
+// the acquisition site of each resource, in shards picked by the handle, so
+// that the resources still held can be listed, e.g. the file descriptors
+// leaked by a server. Resource types beyond 64 per shard are not counted.
+//
+// The sink installed before is still called after the registry.
+class resource_registry {
+  static constexpr std::size_t shards = 64;
+
+  detail::_count_shard counts_[shards];
+  detail::_handle_shard handles_[shards];
+  std::atomic<bool> tracking_{false};
+  std::atomic<scope_sink> next_{nullptr};
+
+  static resource_registry &_instance() noexcept {
+    // never destroyed, resources may be released during static destruction
+    static auto *registry = new resource_registry{};
+    return *registry;
+  }
+
+  void _count(scope_site *site, std::int64_t delta) noexcept {
+    if (auto *live = counts_[detail::_current_cpu() % shards].find(site))
+      live->fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  void _track(scope_record const &r) noexcept {
+    auto &shard = handles_[std::hash<std::uintptr_t>{}(r.handle) % shards];
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    SCOPE_TRY {
+      shard.handles.emplace(r.handle, detail::_handle_shard::held{r.site, r.where});
+    } SCOPE_CATCH_ALL {
+    }
+  }
+  void _untrack(scope_record const &r) noexcept {
+    auto &shard = handles_[std::hash<std::uintptr_t>{}(r.handle) % shards];
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    auto const range = shard.handles.equal_range(r.handle);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.site == r.site) {
+        shard.handles.erase(it);
+        return;
+      }
+    }
+  }
+
+public:
+  struct type_count {
+    char const *name;
+    std::int64_t live;
+  };
+  struct held_resource {
+    char const *name;
+    std::uintptr_t handle;
+    scope_location where;
+  };
+
+  // Starts counting, and tracking each resource if track_handles is true.
+  // Only resources acquired after that are tracked.
+  static void install(bool track_handles = false) noexcept {
+    auto &registry = _instance();
+    registry.tracking_.store(track_handles, std::memory_order_relaxed);
+    auto const previous = set_scope_sink(&record);
+    if (previous != &record)
+      registry.next_.store(previous, std::memory_order_release);
+  }
+
+  static void record(scope_record const &r) noexcept {
+    auto &registry = _instance();
+    if (r.kind == scope_kind::resource) {
+      auto const tracking = registry.tracking_.load(std::memory_order_relaxed);
+      switch (r.event) {
+      case scope_event::constructed:
+      case scope_event::reset:
+        registry._count(r.site, 1);
+        if (tracking)
+          registry._track(r);
+        break;
+      case scope_event::released:
+      case scope_event::deleted:
+        registry._count(r.site, -1);
+        if (tracking)
+          registry._untrack(r);
+        break;
+      default:
+        break;
+      }
+    }
+    if (auto const next = registry.next_.load(std::memory_order_acquire))
+      next(r);
+  }
+
+  // the number of live resources of each type that has been counted
+  static std::vector<type_count> counts() {
+    auto &registry = _instance();
+    std::unordered_map<scope_site *, std::int64_t> live;
+    for (auto &shard : registry.counts_) {
+      for (auto &slot : shard.slots) {
+        if (auto *site = slot.site.load(std::memory_order_acquire))
+          live[site] += slot.live.load(std::memory_order_relaxed);
+      }
+    }
+    std::vector<type_count> result;
+    result.reserve(live.size());
+    for (auto const &[site, n] : live) {
+      result.push_back(type_count{site->name, n});
+    }
+    return result;
+  }
+
+  template <typename R, typename D>
+  static std::int64_t count() noexcept {
+    auto *site     = &detail::_site_of<unique_resource<R, D>>;
+    std::int64_t n = 0;
+    for (auto &shard : _instance().counts_) {
+      for (auto &slot : shard.slots) {
+        if (slot.site.load(std::memory_order_acquire) == site)
+          n += slot.live.load(std::memory_order_relaxed);
+      }
+    }
+    return n;
+  }
+
+  // the tracked resources that are still held
+  static std::vector<held_resource> held() {
+    return _instance()._held(nullptr);
+  }
+  template <typename R, typename D>
+  static std::vector<held_resource> held() {
+    return _instance()._held(&detail::_site_of<unique_resource<R, D>>);
+  }
+
+private:
+  std::vector<held_resource> _held(scope_site *only) {
+    std::vector<held_resource> result;
+    for (auto &shard : handles_) {
+      std::lock_guard<std::mutex> lock{shard.mutex};
+      for (auto const &[handle, h] : shard.handles) {
+        if (!only || h.site == only)
+          result.push_back(held_resource{h.site->name, handle, h.where});
+      }
+    }
+    return result;
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_REGISTRY_HPP_INCLUDE
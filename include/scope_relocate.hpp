@@ -0,0 +1,191 @@
+#ifndef SCOPE_RELOCATE_HPP_INCLUDE
+#define SCOPE_RELOCATE_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace scope {
+
+// Moves the objects of [first, last) to the uninitialized storage at dest and
+// destroys the originals. If T is trivially relocatable, that copies their
+// bytes with a single memmove. dest may overlap [first, last) if it is not
+// after first. Returns the end of the relocated objects.
+template <typename T>
+T *uninitialized_relocate(T *first, T *last, T *dest) noexcept {
+  static_assert(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>,
+                "relocated objects must be trivially relocatable or nothrow move constructible");
+  if constexpr (is_trivially_relocatable_v<T>) {
+    auto const n = static_cast<std::size_t>(last - first);
+    if (n != 0)
+      std::memmove(static_cast<void *>(dest), static_cast<void const *>(first), n * sizeof(T));
+    return dest + n;
+  } else {
+    for (; first != last; ++first, ++dest) {
+      ::new (static_cast<void *>(dest)) T(std::move(*first));
+      first->~T();
+    }
+    return dest;
+  }
+}
+
+// A vector that relocates its elements when it grows or erases, so a
+// trivially relocatable element, e.g. a unique_resource of a handle, is moved
+// by a memmove of the whole array instead of a move construction and
+// destruction per element. The elements are destroyed in reverse order of
+// insertion, as unique_resource_array deletes its resources.
+//
+//   scope::relocating_vector<scope::unique_resource_fn<int, &::close>> connections;
+//   connections.emplace_back(::accept(listener, nullptr, nullptr));
+template <typename T>
+class relocating_vector {
+  static_assert(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>,
+                "elements must be trivially relocatable or nothrow move constructible");
+
+  T *data_{nullptr};
+  std::size_t size_{0};
+  std::size_t capacity_{0};
+
+  static T *_allocate(std::size_t n) {
+    return std::allocator<T>{}.allocate(n);
+  }
+  static void _deallocate(T *p, std::size_t n) noexcept {
+    if (p)
+      std::allocator<T>{}.deallocate(p, n);
+  }
+
+  void _adopt(T *data, std::size_t capacity) noexcept {
+    uninitialized_relocate(data_, data_ + size_, data);
+    _deallocate(data_, capacity_);
+    data_     = data;
+    capacity_ = capacity;
+  }
+
+  // constructs the new element before relocating the others, args may refer
+  // to one of them
+  template <typename... Args>
+  T &_grow_and_emplace_back(Args &&...args) {
+    auto const capacity = capacity_ ? 2 * capacity_ : 4;
+    auto *data          = _allocate(capacity);
+    {
+      auto guard = detail::_quiet_fail([&] { _deallocate(data, capacity); });
+      ::new (static_cast<void *>(data + size_)) T(std::forward<Args>(args)...);
+    }
+    _adopt(data, capacity);
+    return data_[size_++];
+  }
+
+public:
+  relocating_vector() = default;
+  relocating_vector(relocating_vector &&that) noexcept
+      : data_{std::exchange(that.data_, nullptr)}
+      , size_{std::exchange(that.size_, 0)}
+      , capacity_{std::exchange(that.capacity_, 0)} {}
+  relocating_vector &operator=(relocating_vector &&that) noexcept {
+    if (&that != this) {
+      clear();
+      _deallocate(data_, capacity_);
+      data_     = std::exchange(that.data_, nullptr);
+      size_     = std::exchange(that.size_, 0);
+      capacity_ = std::exchange(that.capacity_, 0);
+    }
+    return *this;
+  }
+  ~relocating_vector() {
+    clear();
+    _deallocate(data_, capacity_);
+  }
+
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    if (size_ == capacity_)
+      return _grow_and_emplace_back(std::forward<Args>(args)...);
+    ::new (static_cast<void *>(data_ + size_)) T(std::forward<Args>(args)...);
+    return data_[size_++];
+  }
+  void push_back(T &&value) {
+    emplace_back(std::move(value));
+  }
+  void push_back(T const &value) {
+    emplace_back(value);
+  }
+  void pop_back() noexcept {
+    data_[--size_].~T();
+  }
+  // destroys the element at pos and relocates the ones after it down,
+  // returns the element taking its place
+  T *erase(T const *pos) noexcept {
+    auto *element = data_ + (pos - data_);
+    element->~T();
+    uninitialized_relocate(element + 1, data_ + size_, element);
+    --size_;
+    return element;
+  }
+  // destroys the element at pos and relocates the last one into its place,
+  // which does not preserve the order of the elements
+  T *erase_unordered(T const *pos) noexcept {
+    auto *element = data_ + (pos - data_);
+    element->~T();
+    if (--size_ != static_cast<std::size_t>(element - data_))
+      uninitialized_relocate(data_ + size_, data_ + size_ + 1, element);
+    return element;
+  }
+  void clear() noexcept {
+    while (size_ != 0) {
+      pop_back();
+    }
+  }
+
+  void reserve(std::size_t n) {
+    if (n > capacity_)
+      _adopt(_allocate(n), n);
+  }
+  std::size_t size() const noexcept {
+    return size_;
+  }
+  std::size_t capacity() const noexcept {
+    return capacity_;
+  }
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+  T &operator[](std::size_t i) noexcept {
+    return data_[i];
+  }
+  T const &operator[](std::size_t i) const noexcept {
+    return data_[i];
+  }
+  T &back() noexcept {
+    return data_[size_ - 1];
+  }
+  T const &back() const noexcept {
+    return data_[size_ - 1];
+  }
+  T *data() noexcept {
+    return data_;
+  }
+  T const *data() const noexcept {
+    return data_;
+  }
+  T *begin() noexcept {
+    return data_;
+  }
+  T const *begin() const noexcept {
+    return data_;
+  }
+  T *end() noexcept {
+    return data_ + size_;
+  }
+  T const *end() const noexcept {
+    return data_ + size_;
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_RELOCATE_HPP_INCLUDE
@@ -0,0 +1,158 @@
+#ifndef SCOPE_SHARED_HPP_INCLUDE
+#define SCOPE_SHARED_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace scope {
+namespace detail {
+
+struct _atomic_count {
+  std::atomic<long> count_{1};
+
+  void add() noexcept {
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // whether the last reference is gone
+  bool drop() noexcept {
+    return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+  long get() const noexcept {
+    return count_.load(std::memory_order_relaxed);
+  }
+};
+
+struct _local_count {
+  long count_{1};
+
+  void add() noexcept {
+    ++count_;
+  }
+  bool drop() noexcept {
+    return --count_ == 0;
+  }
+  long get() const noexcept {
+    return count_;
+  }
+};
+
+// the reference count and the resource, in one allocation
+template <typename R, typename D, typename Count>
+struct _shared_block {
+  Count count;
+  unique_resource<R, D> resource;
+
+  explicit _shared_block(unique_resource<R, D> &&r) noexcept(
+      std::is_nothrow_move_constructible_v<unique_resource<R, D>>)
+      : resource(std::move(r)) {}
+};
+} // namespace detail
+
+// Shared ownership of a resource, e.g. a file descriptor used by a reader and
+// a writer. The resource, its deleter and the reference count live in a single
+// allocation, unlike with std::shared_ptr and a custom deleter, which also
+// needs the resource to be a pointer. The last copy to be destroyed or reset
+// deletes the resource, as a unique_resource would.
+//
+// The reference count is atomic, so copies can be used from several threads.
+// local_shared_resource counts without atomic operations instead, for copies
+// that never leave the thread that made them.
+//
+//   scope::shared_resource fd{::open(name, O_RDWR), &::close};
+//   std::thread reader{[fd] { ::read(fd.get(), buffer, size); }};
+template <typename R, typename D, bool Atomic = true>
+class shared_resource {
+  using block = detail::_shared_block<R, D, std::conditional_t<Atomic, detail::_atomic_count, detail::_local_count>>;
+
+  block *block_{nullptr};
+
+public:
+  // owns nothing
+  shared_resource() noexcept = default;
+  // Takes the ownership of the resource of r. If the allocation fails, r is
+  // left unchanged. If r owns nothing, e.g. after release() or with its
+  // resource_traits invalid value, neither does *this, without allocating.
+  explicit shared_resource(unique_resource<R, D> &&r)
+      : block_{detail::hidden::factory_holder::owns(r) ? new block{std::move(r)} : nullptr} {}
+  // If the allocation fails, r is deleted before the exception propagates.
+  template <typename RR,
+            typename DD,
+            typename = std::enable_if_t<std::is_constructible_v<unique_resource<R, D>, RR, DD>>>
+  shared_resource(RR &&r, DD &&d)
+      : shared_resource(unique_resource<R, D>(std::forward<RR>(r), std::forward<DD>(d))) {}
+  shared_resource(shared_resource const &that) noexcept
+      : block_{that.block_} {
+    if (block_)
+      block_->count.add();
+  }
+  shared_resource(shared_resource &&that) noexcept
+      : block_{std::exchange(that.block_, nullptr)} {}
+  shared_resource &operator=(shared_resource const &that) noexcept {
+    shared_resource{that}.swap(*this);
+    return *this;
+  }
+  shared_resource &operator=(shared_resource &&that) noexcept {
+    shared_resource{std::move(that)}.swap(*this);
+    return *this;
+  }
+  ~shared_resource() {
+    reset();
+  }
+
+  // gives up this reference, the resource is deleted if it was the last one
+  void reset() noexcept {
+    if (auto *b = std::exchange(block_, nullptr); b && b->count.drop())
+      delete b;
+  }
+  void swap(shared_resource &that) noexcept {
+    std::swap(block_, that.block_);
+  }
+
+  // Requires: *this owns a resource
+  decltype(auto) get() const noexcept {
+    return block_->resource.get();
+  }
+  decltype(auto) get_deleter() const noexcept {
+    return block_->resource.get_deleter();
+  }
+  // the number of shared_resource sharing the resource, 0 if there is none
+  long use_count() const noexcept {
+    return block_ ? block_->count.get() : 0;
+  }
+  explicit operator bool() const noexcept {
+    return block_ != nullptr;
+  }
+};
+
+template <typename R, typename D>
+using local_shared_resource = shared_resource<R, D, false>;
+
+template <typename R, typename D>
+shared_resource(R, D) -> shared_resource<R, D>;
+template <typename R, typename D>
+shared_resource(unique_resource<R, D> &&) -> shared_resource<R, D>;
+
+// A shared_resource of r, or one owning nothing if r == invalid, without
+// allocating then.
+//
+//   auto fd = scope::make_shared_resource_checked(::open(name, O_RDONLY), -1, &::close);
+template <typename MR, typename MS, typename MD>
+[[nodiscard]] auto make_shared_resource_checked(MR &&r, MS const &invalid, MD &&d)
+    -> shared_resource<std::decay_t<MR>, std::decay_t<MD>> {
+  using result = shared_resource<std::decay_t<MR>, std::decay_t<MD>>;
+  if (r == invalid)
+    return result{};
+  return result{std::forward<MR>(r), std::forward<MD>(d)};
+}
+
+// a shared_resource holds a pointer to its block only
+template <typename R, typename D, bool Atomic>
+struct is_trivially_relocatable<shared_resource<R, D, Atomic>> : std::true_type {};
+
+} // namespace scope
+
+#endif // SCOPE_SHARED_HPP_INCLUDE
@@ -0,0 +1,254 @@
+#ifndef SCOPE_STACK_HPP_INCLUDE
+#define SCOPE_STACK_HPP_INCLUDE
+
+#include "scope.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace scope {
+namespace detail {
+
+// LIFO storage for type erased void() callables. The callables are placed
+// in an inline buffer first and then in heap allocated chunks. The chunks are
+// kept around when the stack is emptied, so a stack that is reused does not
+// allocate again.
+template <std::size_t InlineSize>
+class _callback_stack {
+  static_assert(InlineSize > 0, "the inline buffer can not be empty");
+
+  struct entry {
+    // invokes the callable stored behind the entry (if execute is true) and
+    // destroys it
+    void (*run)(entry *, bool execute);
+    entry *previous;
+  };
+  struct chunk {
+    chunk *next;
+    std::size_t capacity;
+
+    std::byte *begin() noexcept {
+      return reinterpret_cast<std::byte *>(this + 1);
+    }
+    std::byte *end() noexcept {
+      return begin() + capacity;
+    }
+  };
+
+  static std::byte *_align(std::byte *p, std::size_t alignment) noexcept {
+    auto const address = reinterpret_cast<std::uintptr_t>(p);
+    return p + ((alignment - address % alignment) % alignment);
+  }
+  static std::byte *_callable_of(entry *e, std::size_t alignment) noexcept {
+    return _align(reinterpret_cast<std::byte *>(e + 1), alignment);
+  }
+  // the end of an entry holding a callable of the given size and alignment
+  // when it is placed at p
+  static std::byte *_end_of(std::byte *p, std::size_t size, std::size_t alignment) noexcept {
+    return _callable_of(reinterpret_cast<entry *>(_align(p, alignof(entry))), alignment) + size;
+  }
+
+  template <typename F>
+  static void _run(entry *e, bool execute) {
+    F &f         = *std::launder(reinterpret_cast<F *>(_callable_of(e, alignof(F))));
+    auto destroy = _quiet_exit([&f] { f.~F(); }); // also if f throws
+    if (execute)
+      f();
+  }
+
+  alignas(std::max_align_t) std::byte buffer_[InlineSize];
+  std::byte *cursor_{buffer_};
+  std::byte *limit_{buffer_ + InlineSize};
+  entry *top_{nullptr};
+  chunk *chunks_{nullptr};  // every chunk ever allocated, in use order
+  chunk *current_{nullptr}; // the chunk cursor_ points into, nullptr for buffer_
+  std::size_t size_{0};
+  bool trivial_{true}; // no stored callable has to be destroyed
+
+  // moves to the next chunk that can hold the entry, allocating it if needed
+  void _grow(std::size_t size, std::size_t alignment) {
+    chunk *next            = current_ ? current_->next : chunks_;
+    std::size_t const need = sizeof(entry) + alignof(entry) + size + alignment;
+    if (!next || next->capacity < need) {
+      std::size_t capacity = current_ ? 2 * current_->capacity : 4 * InlineSize;
+      if (capacity < need)
+        capacity = need;
+      auto *fresh = ::new (::operator new(sizeof(chunk) + capacity)) chunk{next, capacity};
+      if (current_)
+        current_->next = fresh;
+      else
+        chunks_ = fresh;
+      next = fresh;
+    }
+    current_ = next;
+    cursor_  = next->begin();
+    limit_   = next->end();
+  }
+
+public:
+  _callback_stack() noexcept = default;
+  _callback_stack(_callback_stack const &)            = delete;
+  _callback_stack &operator=(_callback_stack const &) = delete;
+  ~_callback_stack() {
+    unwind(false);
+    while (chunks_) {
+      auto *next = chunks_->next;
+      ::operator delete(chunks_);
+      chunks_ = next;
+    }
+  }
+
+  // true if a callable of type F can be stored without allocating
+  template <typename F>
+  bool fits() const noexcept {
+    return _end_of(cursor_, sizeof(F), alignof(F)) <= limit_;
+  }
+
+  // only allocates if !fits<F>()
+  template <typename F, typename FF>
+  void push(FF &&f) {
+    if (!fits<F>())
+      _grow(sizeof(F), alignof(F));
+    auto *e = reinterpret_cast<entry *>(_align(cursor_, alignof(entry)));
+    ::new (static_cast<void *>(_callable_of(e, alignof(F)))) F(std::forward<FF>(f));
+    ::new (static_cast<void *>(e)) entry{&_run<F>, top_};
+    top_    = e;
+    cursor_ = _callable_of(e, alignof(F)) + sizeof(F);
+    ++size_;
+    trivial_ = trivial_ && std::is_trivially_destructible_v<F>;
+  }
+
+  // runs (if execute is true) and destroys the callables in reverse order of
+  // their pushes, the storage is kept for reuse. If a callable throws, it is
+  // destroyed and the ones pushed before it stay on the stack.
+  void unwind(bool execute) {
+    if (execute || !trivial_) {
+      while (top_) {
+        auto *e = std::exchange(top_, top_->previous);
+        --size_;
+        e->run(e, execute);
+      }
+    }
+    top_     = nullptr;
+    size_    = 0;
+    trivial_ = true;
+    cursor_  = buffer_;
+    limit_   = buffer_ + InlineSize;
+    current_ = nullptr;
+  }
+
+  std::size_t size() const noexcept {
+    return size_;
+  }
+};
+} // namespace detail
+
+// A scope guard for a number of exit functions that is only known at run
+// time. The exit functions are run in reverse order of their pushes when
+// the policy says so. They are stored inline up to InlineSize bytes (including
+// a two pointer header per function) and in geometrically growing chunks
+// after that.
+//
+// An exception escaping from an exit function run by the destructor
+// terminates the program.
+template <class Policy, std::size_t InlineSize>
+class [[nodiscard]] basic_scope_stack : Policy {
+protected:
+  detail::_callback_stack<InlineSize> callbacks_;
+
+public:
+  basic_scope_stack() = default;
+  basic_scope_stack(basic_scope_stack const &)            = delete;
+  basic_scope_stack &operator=(basic_scope_stack const &) = delete;
+  ~basic_scope_stack() {
+    callbacks_.unwind(callbacks_.size() != 0 && this->should_execute());
+  }
+
+  // Requires: EF is Callable
+  // If storing the exit function fails, it is invoked as if it was the exit
+  // function of a basic_scope_exit<EF, Policy> failing to be constructed.
+  template <typename EFP>
+  void push(EFP &&ef) {
+    using EF = std::decay_t<EFP>;
+    static_assert(std::is_invocable_v<EF &>, "scope guard must be callable");
+    if constexpr (std::is_nothrow_constructible_v<EF, EFP>) {
+      if (callbacks_.template fits<EF>()) {
+        callbacks_.template push<EF>(std::forward<EFP>(ef));
+        return;
+      }
+    }
+    auto failsafe =
+        basic_scope_exit<std::remove_reference_t<EFP> &, detail::_quiet<Policy>>(ef, detail::_quiet<Policy>(*this));
+    callbacks_.template push<EF>(detail::_forward_keeping<EF, EFP>(ef));
+    failsafe.release();
+  }
+
+  // drops all the pushed exit functions without invoking them, more exit
+  // functions can be pushed afterwards
+  void release() noexcept {
+    callbacks_.unwind(false);
+  }
+
+  std::size_t size() const noexcept {
+    return callbacks_.size();
+  }
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+};
+
+template <std::size_t InlineSize = 256>
+struct [[nodiscard]] scope_stack : basic_scope_stack<detail::on_exit_policy, InlineSize> {};
+
+template <std::size_t InlineSize = 256>
+struct [[nodiscard]] scope_fail_stack : basic_scope_stack<detail::on_fail_policy, InlineSize> {};
+
+template <std::size_t InlineSize = 256>
+struct [[nodiscard]] scope_success_stack : basic_scope_stack<detail::on_success_policy, InlineSize> {};
+
+// A journal of undo actions for updates done in several steps. The undo
+// actions are run in reverse order of their registration when the
+// transaction is destroyed without being committed, normally or by an
+// exception. commit() drops them without running them, which takes constant
+// time when they are trivially destructible (e.g. lambdas capturing by
+// reference).
+//
+//   scope::scope_transaction tx;
+//   for (auto &key : keys) {
+//     index.insert(key);
+//     tx.on_rollback([&] { index.erase(key); });
+//   }
+//   tx.commit();
+template <std::size_t InlineSize = 256>
+class [[nodiscard]] scope_transaction : basic_scope_stack<detail::on_exit_policy, InlineSize> {
+  using base = basic_scope_stack<detail::on_exit_policy, InlineSize>;
+
+public:
+  // If the undo action can not be registered, it is run before the
+  // exception propagates, undoing the step it belongs to.
+  template <typename EFP>
+  void on_rollback(EFP &&undo) {
+    base::push(std::forward<EFP>(undo));
+  }
+
+  void commit() noexcept {
+    base::release();
+  }
+  // Runs the pending undo actions now, the transaction can be used again. If
+  // an undo action throws, the exception propagates and the actions
+  // registered before it stay pending, they run on the next rollback() or
+  // when the transaction is destroyed.
+  void rollback() {
+    this->callbacks_.unwind(true);
+  }
+
+  using base::empty;
+  using base::size;
+};
+
+} // namespace scope
+
+#endif // SCOPE_STACK_HPP_INCLUDE
@@ -0,0 +1,243 @@
+#ifndef SCOPE_TABLE_HPP_INCLUDE
+#define SCOPE_TABLE_HPP_INCLUDE
+
+#include "scope.hpp"
+#include "scope_relocate.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace scope {
+
+// Owns resources in a dense array and refers to them by handles, which stay
+// valid until the resource is erased, e.g. sockets referenced from timers,
+// queues and other connections. A handle is an index into a table of slots,
+// tagged with the generation of the slot, which changes each time the slot is
+// freed, so the handles of erased resources are detected as stale. Finding and
+// erasing a resource take constant time, and the resources are stored
+// contiguously, without a node per resource.
+//
+// A 64 bit handle has 32 bits of index and 32 of generation, a 32 bit one 20
+// bits of index and 12 of generation. A slot whose generation is exhausted is
+// not reused, so a stale handle is never taken for a new one.
+//
+//   scope::resource_table<int, scope::function_deleter<&::close>> sockets;
+//   auto h = sockets.emplace(::accept(listener, nullptr, nullptr));
+//   ...
+//   if (auto *socket = sockets.find(h))
+//     ::send(socket->get(), data, size, 0);
+//   sockets.erase(h); // closes the socket, h is stale from now on
+//
+// Requires: the deleter does not access the table
+template <typename R, typename D, typename Handle = std::uint64_t>
+class resource_table {
+  static_assert(std::is_same_v<Handle, std::uint32_t> || std::is_same_v<Handle, std::uint64_t>,
+                "handles must be 32 or 64 bit unsigned integers");
+
+  static constexpr unsigned index_bits_ = sizeof(Handle) == 4 ? 20 : 32;
+  static constexpr std::uint64_t generations_ = std::uint64_t{1} << (sizeof(Handle) * 8 - index_bits_);
+  static constexpr std::uint32_t no_slot_ = ~std::uint32_t{0};
+  // the largest number of slots, no_slot_ is not a valid index
+  static constexpr std::uint64_t max_slots_ = sizeof(Handle) == 4 ? std::uint64_t{1} << index_bits_ : no_slot_;
+
+  struct slot {
+    // the position of the resource in dense_, or the next free slot
+    std::uint32_t position;
+    // starts at 1, so that a handle is never 0
+    std::uint32_t generation;
+  };
+
+  relocating_vector<unique_resource<R, D>> dense_;
+  std::vector<std::uint32_t> slot_of_; // the slot of each resource in dense_
+  std::vector<slot> slots_;
+  std::uint32_t free_{no_slot_};
+
+public:
+  class handle {
+    friend class resource_table;
+
+    Handle value_{0};
+
+    handle(std::uint32_t index, std::uint32_t generation) noexcept
+        : value_{static_cast<Handle>(static_cast<Handle>(generation) << index_bits_ | index)} {}
+    std::uint32_t _index() const noexcept {
+      return static_cast<std::uint32_t>(value_ & ((Handle{1} << index_bits_) - 1));
+    }
+    std::uint32_t _generation() const noexcept {
+      return static_cast<std::uint32_t>(value_ >> index_bits_);
+    }
+
+  public:
+    // refers to nothing
+    constexpr handle() noexcept = default;
+    // from value(), e.g. after it went through a C API as user data
+    constexpr explicit handle(Handle value) noexcept
+        : value_{value} {}
+    constexpr Handle value() const noexcept {
+      return value_;
+    }
+    constexpr explicit operator bool() const noexcept {
+      return value_ != 0;
+    }
+    friend constexpr bool operator==(handle a, handle b) noexcept {
+      return a.value_ == b.value_;
+    }
+    friend constexpr bool operator!=(handle a, handle b) noexcept {
+      return a.value_ != b.value_;
+    }
+  };
+
+private:
+  slot const *_slot(handle h) const noexcept {
+    auto const index = h._index();
+    if (index >= slots_.size() || h._generation() == 0 || slots_[index].generation != h._generation())
+      return nullptr;
+    return &slots_[index];
+  }
+
+  // Takes the ownership of r. The storage is allocated first, so r is
+  // unchanged if that fails. Returns a null handle if the table is full.
+  template <typename RR>
+  handle _insert(RR &&r) {
+    if (free_ == no_slot_) {
+      if (slots_.size() == max_slots_)
+        return handle{};
+      slots_.push_back(slot{no_slot_, 1});
+      free_ = static_cast<std::uint32_t>(slots_.size() - 1);
+    }
+    if (dense_.size() == dense_.capacity())
+      dense_.reserve(dense_.empty() ? 16 : 2 * dense_.size());
+    slot_of_.reserve(dense_.capacity());
+    dense_.emplace_back(std::forward<RR>(r));
+    auto const index = free_;
+    auto &s          = slots_[index];
+    free_            = s.position;
+    s.position       = static_cast<std::uint32_t>(dense_.size() - 1);
+    slot_of_.push_back(index);
+    return handle{index, s.generation};
+  }
+
+  // the handles of the slot become stale
+  void _free(std::uint32_t index) noexcept {
+    auto &s = slots_[index];
+    if (s.generation == generations_ - 1) {
+      s.generation = 0; // retired, no handle has generation 0
+      return;
+    }
+    ++s.generation;
+    s.position = free_;
+    free_      = index;
+  }
+
+public:
+  using resource = unique_resource<R, D>;
+
+  resource_table() = default;
+  resource_table(resource_table &&that) noexcept
+      : dense_{std::move(that.dense_)}
+      , slot_of_{std::move(that.slot_of_)}
+      , slots_{std::move(that.slots_)}
+      , free_{std::exchange(that.free_, no_slot_)} {}
+  resource_table &operator=(resource_table &&that) noexcept {
+    if (&that != this) {
+      clear();
+      dense_   = std::move(that.dense_);
+      slot_of_ = std::move(that.slot_of_);
+      slots_   = std::move(that.slots_);
+      free_    = std::exchange(that.free_, no_slot_);
+    }
+    return *this;
+  }
+  ~resource_table() = default;
+
+  // Takes the ownership of the resource of r. Returns a null handle if the
+  // table is full, r is unchanged then, as it is if an allocation fails.
+  handle insert(resource &&r) {
+    return _insert(std::move(r));
+  }
+  // Constructs a unique_resource from args and takes its ownership. If the
+  // table is full, the resource is deleted and a null handle is returned.
+  template <typename... Args>
+  handle emplace(Args &&...args) {
+    return insert(resource(std::forward<Args>(args)...));
+  }
+
+  // nullptr if h is stale or null
+  resource *find(handle h) noexcept {
+    auto const *s = _slot(h);
+    return s ? &dense_[s->position] : nullptr;
+  }
+  resource const *find(handle h) const noexcept {
+    auto const *s = _slot(h);
+    return s ? &dense_[s->position] : nullptr;
+  }
+  bool contains(handle h) const noexcept {
+    return _slot(h) != nullptr;
+  }
+
+  // Deletes the resource of h, as a unique_resource going out of scope does,
+  // returns false if h is stale or null. To keep the resource, move it out of
+  // find(h) first.
+  bool erase(handle h) noexcept {
+    auto const *s = _slot(h);
+    if (!s)
+      return false;
+    auto const index    = h._index();
+    auto const position = s->position;
+    // the last resource takes the place of the erased one
+    auto const moved       = slot_of_.back();
+    slot_of_[position]     = moved;
+    slots_[moved].position = position;
+    slot_of_.pop_back();
+    _free(index);
+    dense_.erase_unordered(dense_.begin() + position);
+    return true;
+  }
+
+  // deletes all the resources, all handles become stale
+  void clear() noexcept {
+    while (!dense_.empty()) {
+      _free(slot_of_.back());
+      slot_of_.pop_back();
+      dense_.pop_back();
+    }
+  }
+
+  void reserve(std::size_t n) {
+    dense_.reserve(n);
+    slot_of_.reserve(n);
+    slots_.reserve(n);
+  }
+  std::size_t size() const noexcept {
+    return dense_.size();
+  }
+  bool empty() const noexcept {
+    return dense_.empty();
+  }
+
+  // the resources, in no particular order
+  resource *begin() noexcept {
+    return dense_.begin();
+  }
+  resource const *begin() const noexcept {
+    return dense_.begin();
+  }
+  resource *end() noexcept {
+    return dense_.end();
+  }
+  resource const *end() const noexcept {
+    return dense_.end();
+  }
+  // the handle of the resource at position i of [begin(), end())
+  handle handle_at(std::size_t i) const noexcept {
+    auto const index = slot_of_[i];
+    return handle{index, slots_[index].generation};
+  }
+};
+
+} // namespace scope
+
+#endif // SCOPE_TABLE_HPP_INCLUDE
@@ -0,0 +1,88 @@
+# Compares the object code of the scope_* functions of codegen.cpp with the
+# one of their manual_* counterparts and fails if a scope_* function has more
+# branches, calls, or stores. Parts moved out of line (e.g. foo.cold) count
+# for their function. The disassembly is x86-64 AT&T syntax.
+#
+# Usage: cmake -DOBJDUMP=<objdump> -DOBJECT=<codegen object file> -P check_codegen.cmake
+
+cmake_minimum_required(VERSION 3.12)
+
+foreach(var OBJDUMP OBJECT)
+  if(NOT DEFINED ${var})
+    message(FATAL_ERROR "${var} must be defined")
+  endif()
+endforeach()
+
+execute_process(
+  COMMAND "${OBJDUMP}" -d --no-show-raw-insn "${OBJECT}"
+  OUTPUT_VARIABLE disassembly
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${OBJDUMP} failed on ${OBJECT}")
+endif()
+
+string(REPLACE ";" "," disassembly "${disassembly}")
+string(REPLACE "\n" ";" lines "${disassembly}")
+
+set(functions)
+set(function "")
+foreach(line IN LISTS lines)
+  if(line MATCHES "^[0-9a-f]+ <([A-Za-z0-9_]+)(\\.[a-z]+)?>:$")
+    set(function "${CMAKE_MATCH_1}")
+    if(NOT function IN_LIST functions)
+      list(APPEND functions "${function}")
+      foreach(kind instructions branches calls stores)
+        set(${function}_${kind} 0)
+      endforeach()
+    endif()
+  elseif(function AND line MATCHES "^ +[0-9a-f]+:\t([a-z0-9]+)[ \t]*(.*)$")
+    set(mnemonic "${CMAKE_MATCH_1}")
+    set(operands "${CMAKE_MATCH_2}")
+    if(mnemonic MATCHES "^(nop|data16|xchg %ax,%ax)")
+      continue()
+    endif()
+    math(EXPR ${function}_instructions "${${function}_instructions} + 1")
+    # the destination is the last operand, a memory one has parentheses
+    string(REGEX REPLACE ".*," "" destination "${operands}")
+    if(mnemonic MATCHES "^call")
+      math(EXPR ${function}_calls "${${function}_calls} + 1")
+    elseif(mnemonic MATCHES "^j")
+      math(EXPR ${function}_branches "${${function}_branches} + 1")
+    elseif(mnemonic MATCHES "^(push|stos|movs)" OR (destination MATCHES "\\(" AND NOT mnemonic MATCHES "^(cmp|test|lea|bt)"))
+      math(EXPR ${function}_stores "${${function}_stores} + 1")
+    endif()
+  endif()
+endforeach()
+
+set(failed FALSE)
+set(compared 0)
+foreach(function IN LISTS functions)
+  if(NOT function MATCHES "^scope_(.*)$")
+    continue()
+  endif()
+  set(manual "manual_${CMAKE_MATCH_1}")
+  if(NOT manual IN_LIST functions)
+    message(SEND_ERROR "${function} has no ${manual} to compare with")
+    set(failed TRUE)
+    continue()
+  endif()
+  math(EXPR compared "${compared} + 1")
+  set(report "${function}:")
+  foreach(kind instructions branches calls stores)
+    string(APPEND report " ${kind} ${${function}_${kind}}/${${manual}_${kind}}")
+  endforeach()
+  message(STATUS "${report}")
+  foreach(kind branches calls stores)
+    if(${function}_${kind} GREATER ${manual}_${kind})
+      message(SEND_ERROR "${function} has more ${kind} than ${manual}")
+      set(failed TRUE)
+    endif()
+  endforeach()
+endforeach()
+
+if(compared EQUAL 0)
+  message(FATAL_ERROR "no scope_* function found in ${OBJECT}")
+endif()
+if(failed)
+  message(FATAL_ERROR "the abstractions are not free anymore")
+endif()
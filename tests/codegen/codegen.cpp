@@ -0,0 +1,116 @@
+#include "scope.hpp"
+
+#include <exception>
+
+// Each scope_* function is compiled next to a manual_* function doing the
+// same with hand written RAII, check_codegen.cmake compares their object code.
+// The functions they call are only declared, so the calls can not be folded.
+
+extern "C" {
+void cleanup(int) noexcept;
+void work(int);
+int acquire() noexcept;
+void release(int) noexcept;
+}
+
+namespace {
+struct manual_exit {
+  int x;
+  ~manual_exit() {
+    cleanup(x);
+  }
+};
+
+struct manual_fail {
+  int x;
+  int ec{std::uncaught_exceptions()};
+  ~manual_fail() {
+    if (ec < std::uncaught_exceptions())
+      cleanup(x);
+  }
+};
+
+// three cleanups behind one exception check
+struct manual_fail_three {
+  int x;
+  int ec{std::uncaught_exceptions()};
+  ~manual_fail_three() {
+    if (ec < std::uncaught_exceptions()) {
+      cleanup(x + 2);
+      cleanup(x + 1);
+      cleanup(x);
+    }
+  }
+};
+
+struct manual_fd {
+  int fd;
+  void (*deleter)(int) noexcept;
+  ~manual_fd() {
+    deleter(fd);
+  }
+};
+
+struct manual_fd_direct {
+  int fd;
+  ~manual_fd_direct() {
+    release(fd);
+  }
+};
+} // namespace
+
+extern "C" {
+void scope_exit_macro(int x) {
+  SCOPE_EXIT([x] { cleanup(x); });
+  work(x);
+}
+void manual_exit_macro(int x) {
+  manual_exit guard{x};
+  work(x);
+}
+
+void scope_fail_guard(int x) {
+  scope::scope_fail guard{[x] { cleanup(x); }};
+  work(x);
+}
+void manual_fail_guard(int x) {
+  manual_fail guard{x};
+  work(x);
+}
+
+void scope_fail_group(int x) {
+  SCOPE_GROUP_FAIL([x] { cleanup(x); }, [x] { cleanup(x + 1); }, [x] { cleanup(x + 2); });
+  work(x);
+}
+void manual_fail_group(int x) {
+  manual_fail_three guard{x};
+  work(x);
+}
+
+void scope_resource_function_pointer() {
+  scope::unique_resource<int, void (*)(int) noexcept> fd{acquire(), &release};
+  work(fd.get());
+}
+void manual_resource_function_pointer() {
+  manual_fd fd{acquire(), &release};
+  work(fd.fd);
+}
+
+void scope_resource_lambda() {
+  scope::unique_resource fd{acquire(), [](int fd) noexcept { release(fd); }};
+  work(fd.get());
+}
+void manual_resource_lambda() {
+  manual_fd_direct fd{acquire()};
+  work(fd.fd);
+}
+
+void scope_resource_fn() {
+  scope::unique_resource_fn<int, &release> fd{acquire()};
+  work(fd.get());
+}
+void manual_resource_fn() {
+  manual_fd_direct fd{acquire()};
+  work(fd.fd);
+}
+}
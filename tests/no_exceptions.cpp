@@ -0,0 +1,125 @@
+// Compiled without exception support, e.g. -fno-exceptions, to check that the
+// headers do not need it. It does not use Catch2, which does.
+#include "scope.hpp"
+#include "scope_any.hpp"
+#include "scope_arena.hpp"
+#include "scope_array.hpp"
+#include "scope_async.hpp"
+#include "scope_deferred.hpp"
+#include "scope_epoch.hpp"
+#include "scope_pool.hpp"
+#include "scope_stack.hpp"
+
+#include <cstdio>
+#include <optional>
+#include <system_error>
+
+#if !SCOPE_NO_EXCEPTIONS
+#error "compile with exceptions disabled"
+#endif
+
+namespace {
+int failures = 0;
+
+#define CHECK(...)                                                                                                     \
+  do {                                                                                                                 \
+    if (!(__VA_ARGS__)) {                                                                                              \
+      std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #__VA_ARGS__);                                      \
+      ++failures;                                                                                                      \
+    }                                                                                                                  \
+  } while (false)
+
+struct close_fd {
+  int *closed;
+  void operator()(int) const noexcept {
+    ++*closed;
+  }
+};
+
+void exception_guards() {
+  int exits = 0, fails = 0, successes = 0;
+  {
+    SCOPE_EXIT([&] { ++exits; });
+    SCOPE_FAIL([&] { ++fails; });
+    SCOPE_SUCCESS([&] { ++successes; });
+  }
+  CHECK(exits == 1);
+  CHECK(fails == 0);
+  CHECK(successes == 1);
+}
+
+void status_guards() {
+  int rollbacks = 0, commits = 0;
+  {
+    std::error_code ec;
+    SCOPE_FAIL_ON(ec, [&] { ++rollbacks; });
+    SCOPE_SUCCESS_ON(ec, [&] { ++commits; });
+    ec = std::make_error_code(std::errc::io_error);
+  }
+  CHECK(rollbacks == 1);
+  CHECK(commits == 0);
+  {
+    bool ok = false;
+    scope::scope_fail_on rollback{ok, [&] { ++rollbacks; }};
+    ok = true;
+  }
+  CHECK(rollbacks == 1);
+  {
+    std::optional<int> result;
+    scope::scope_success_on commit{result, [&] { ++commits; }};
+    result = 42;
+  }
+  CHECK(commits == 1);
+}
+
+void resources() {
+  int closed = 0;
+  {
+    scope::unique_resource fd{3, close_fd{&closed}};
+    auto checked = scope::make_unique_resource_checked(-1, -1, close_fd{&closed});
+    scope::unique_resource_array<int, close_fd> all{close_fd{&closed}};
+    all.push_back(4);
+    all.push_back(5);
+  }
+  CHECK(closed == 3);
+
+  scope::object_pool<int> pool{};
+  auto *first = pool.acquire(1).get();
+  CHECK(pool.acquire().get() == first);
+}
+
+void others() {
+  int runs = 0;
+  {
+    scope::scope_stack stack{};
+    stack.push([&] { ++runs; });
+    scope::any_scope_exit any{[&] { ++runs; }};
+  }
+  CHECK(runs == 2);
+  {
+    scope::cleanup_executor executor{};
+    scope::scope_exit_async later{executor, [&] { ++runs; }};
+  }
+  CHECK(runs == 3);
+  {
+    scope::scope_arena arena{};
+    SCOPE_ARENA(arena);
+    CHECK(arena.allocate(16, 8) != nullptr);
+  }
+  scope::epoch_domain domain{};
+  {
+    SCOPE_EPOCH(domain);
+  }
+  domain.retire(&runs, [](int *r) noexcept { ++*r; });
+  domain.synchronize();
+  domain.collect();
+}
+} // namespace
+
+int main() {
+  exception_guards();
+  status_guards();
+  resources();
+  others();
+  return failures == 0 ? 0 : 1;
+}
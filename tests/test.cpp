@@ -39,9 +39,11 @@ SOFTWARE.
 
 #include <filesystem>
 #include <functional>
+#include <optional>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <utility>
 
 // #define CHECK_COMPILE_ERRORS
@@ -694,3 +696,233 @@ TEST_CASE("Macros shall expand to the correct function call and declare differen
   }
   REQUIRE(stream.str() == "fail\nsuccess\nexit\n");
 }
+
+TEST_CASE("Guards created through a scope_frame") {
+  std::ostringstream out{};
+  {
+    scope::scope_frame frame{};
+    auto fail    = frame.fail([&] { out << "not called\n"; });
+    auto success = frame.success([&] { out << "success\n"; });
+  }
+  REQUIRE("success\n" == out.str());
+  out.str("");
+  try {
+    scope::scope_frame frame{};
+    SCOPE_FRAME_FAIL(frame, [&] { out << "fail 1\n"; });
+    SCOPE_FRAME_SUCCESS(frame, [&] { out << "not called\n"; });
+    SCOPE_FRAME_FAIL(frame, [&] { out << "fail 2\n"; });
+    throw 42;
+  } catch (int) {
+    scope::scope_frame frame{};
+    auto success = frame.success([&] { out << "handled\n"; });
+  }
+  REQUIRE("fail 2\nfail 1\nhandled\n" == out.str());
+}
+
+TEST_CASE("Guards deciding from a bound status") {
+  std::ostringstream out{};
+  {
+    std::error_code ec{};
+    SCOPE_FAIL_ON(ec, [&] { out << "rollback\n"; });
+    SCOPE_SUCCESS_ON(ec, [&] { out << "not called\n"; });
+    ec = std::make_error_code(std::errc::io_error);
+  }
+  {
+    bool ok = true;
+    scope::scope_fail_on rollback{ok, [&] { out << "not called\n"; }};
+    scope::scope_success_on commit{ok, [&] { out << "commit\n"; }};
+  }
+  {
+    std::optional<int> result{};
+    scope::scope_fail_on missing{result, [&] { out << "no result\n"; }};
+    scope::scope_success_on released{result, [&] { out << "not called\n"; }};
+    released.release();
+  }
+  REQUIRE("rollback\ncommit\nno result\n" == out.str());
+}
+
+TEST_CASE("Guards deciding from a status ignore exceptions") {
+  std::ostringstream out{};
+  try {
+    bool ok = true;
+    scope::scope_success_on commit{ok, [&] { out << "commit\n"; }};
+    throw 42;
+  } catch (int) {
+  }
+  REQUIRE("commit\n" == out.str());
+  static_assert(!std::is_constructible_v<scope::scope_fail_on<bool, void (*)()>, bool, void (*)()>,
+                "a temporary status would dangle");
+}
+
+TEST_CASE("Test scope_frame with throwing function object") {
+  std::ostringstream out{};
+  scope::scope_frame frame{};
+  throwing_copy fail{"called because of exception!!!", out};
+  REQUIRE_THROWS(frame.fail(fail));
+  throwing_copy success{"Oh noes!!!", out};
+  REQUIRE_THROWS(frame.success(success));
+  REQUIRE("called because of exception!!!\n" == out.str());
+}
+
+TEST_CASE("Guard groups execute in reverse order like separate guards") {
+  std::ostringstream out{};
+  {
+    SCOPE_GROUP_EXIT([&] { out << "1\n"; }, [&] { out << "2\n"; }, [&] { out << "3\n"; });
+    scope::scope_group_exit released{[&] { out << "not called\n"; }};
+    released.release();
+  }
+  REQUIRE("3\n2\n1\n" == out.str());
+  out.str("");
+  try {
+    SCOPE_GROUP_FAIL([&] { out << "fail 1\n"; }, [&] { out << "fail 2\n"; });
+    SCOPE_GROUP_SUCCESS([&] { out << "not called\n"; }, [&] { out << "not called\n"; });
+    throw 42;
+  } catch (int) {
+    SCOPE_GROUP_SUCCESS([&] { out << "handled\n"; });
+  }
+  REQUIRE("fail 2\nfail 1\nhandled\n" == out.str());
+}
+
+TEST_CASE("A guard group is a single guard") {
+  auto first  = [] {};
+  auto second = [] {};
+  int i{};
+  auto by_reference = [&i] { ++i; };
+  using group       = scope::scope_group_fail<decltype(by_reference), decltype(by_reference), decltype(first)>;
+  STATIC_REQUIRE(sizeof(group) < 3 * sizeof(scope::scope_fail<decltype(by_reference)>));
+  STATIC_REQUIRE(sizeof(scope::scope_group_exit<decltype(first), decltype(second)>)
+                 == sizeof(scope::scope_exit<decltype(first)>));
+}
+
+TEST_CASE("Guard groups execute all their functions if copying one throws") {
+  std::ostringstream out{};
+  throwing_copy fail{"called because of exception!!!", out};
+  REQUIRE_THROWS(scope::scope_group_exit(fail, [&] { out << "second\n"; }));
+  REQUIRE("second\ncalled because of exception!!!\n" == out.str());
+}
+
+TEST_CASE("Guard groups execute the functions before one that throws") {
+  std::ostringstream out{};
+  auto const leave_scope = [&out] {
+    scope::scope_group_exit group{[&out] { out << "1\n"; },
+                                  [&out] { out << "2\n"; },
+                                  [&out] {
+                                    out << "3\n";
+                                    throw 42;
+                                  }};
+  };
+  REQUIRE_THROWS_AS(leave_scope(), int);
+  REQUIRE("3\n2\n1\n" == out.str());
+}
+
+TEST_CASE("Guard groups don't move from functions they execute if copying one throws") {
+  std::ostringstream out{};
+  std::string text{"moved from if empty"};
+  REQUIRE_THROWS(scope::scope_group_exit([text, &out] { out << '[' << text << "]\n"; },
+                                         throwing_copy{"called because of exception!!!", out}));
+  REQUIRE("called because of exception!!!\n[moved from if empty]\n" == out.str());
+}
+
+namespace {
+struct counting_closer {
+  static inline std::ostringstream closed{};
+  void operator()(int fd) const noexcept {
+    closed << fd << ' ';
+  }
+};
+struct empty_closer {
+  void operator()(int) const noexcept {}
+};
+} // namespace
+
+template <>
+struct scope::resource_traits<int, counting_closer> {
+  static constexpr int invalid() noexcept {
+    return -1;
+  }
+};
+
+static_assert(sizeof(unique_resource<int, counting_closer>) == sizeof(int));
+static_assert(sizeof(unique_resource<int, empty_closer>) <= 2 * sizeof(int));
+
+TEST_CASE("Test unique_resource with an invalid value from resource_traits") {
+  using fd = unique_resource<int, counting_closer>;
+  auto &closed = counting_closer::closed;
+  closed.str("");
+  {
+    fd owning{3, counting_closer{}};
+    fd not_owning{-1, counting_closer{}};
+    REQUIRE(3 == owning.get());
+  }
+  REQUIRE("3 " == closed.str());
+  closed.str("");
+  {
+    fd released{4, counting_closer{}};
+    released.release();
+    REQUIRE(-1 == released.get());
+    fd resetted{5, counting_closer{}};
+    resetted.reset();
+    REQUIRE(-1 == resetted.get());
+    resetted.reset(6);
+    REQUIRE(6 == resetted.get());
+  }
+  REQUIRE("5 6 " == closed.str());
+  closed.str("");
+  {
+    fd first{7, counting_closer{}};
+    fd second{std::move(first)};
+    REQUIRE(-1 == first.get());
+    REQUIRE(7 == second.get());
+    fd third{8, counting_closer{}};
+    third = std::move(second);
+    REQUIRE(-1 == second.get());
+    REQUIRE(7 == third.get());
+  }
+  REQUIRE("8 7 " == closed.str());
+  closed.str("");
+  {
+    auto checked = make_unique_resource_checked(9, 9, counting_closer{});
+    REQUIRE(-1 == checked.get());
+    auto valid = make_unique_resource_checked(10, -1, counting_closer{});
+  }
+  REQUIRE("10 " == closed.str());
+}
+
+namespace {
+std::string closed_by_function{};
+void close_by_function(int fd) noexcept {
+  closed_by_function += std::to_string(fd) + ' ';
+}
+} // namespace
+
+static_assert(sizeof(scope::unique_resource_fn<int, &close_by_function>) < sizeof(unique_resource<int, void (*)(int)>));
+
+TEST_CASE("Test unique_resource_fn") {
+  closed_by_function.clear();
+  {
+    scope::unique_resource_fn<int, &close_by_function> fd{1};
+    REQUIRE(1 == fd.get());
+    scope::unique_resource_fn<int, &close_by_function> moved{std::move(fd)};
+    auto checked = make_unique_resource_checked<&close_by_function>(2, -1);
+    auto invalid = make_unique_resource_checked<&close_by_function>(-1, -1);
+    static_assert(std::is_same_v<decltype(checked), scope::unique_resource_fn<int, &close_by_function>>);
+  }
+  REQUIRE("2 1 " == closed_by_function);
+  // a default constructed function pointer would be null
+  STATIC_REQUIRE(std::is_constructible_v<scope::unique_resource_fn<int, &close_by_function>, int>);
+  STATIC_REQUIRE(!std::is_constructible_v<unique_resource<int, void (*)(int)>, int>);
+}
+
+TEST_CASE("Demonstrate unique_resource_fn with posix io") {
+  const std::string filename = "./hello1.txt";
+  {
+    scope::unique_resource_fn<int, &::close> file{::open(filename.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0666)};
+    REQUIRE(file.get() != -1);
+    REQUIRE(12 == ::write(file.get(), "Hello World!\n", 12u));
+  }
+  ::unlink(filename.c_str());
+  {
+    auto file = make_unique_resource_checked<&::close>(::open("nonexistingfile.txt", O_RDONLY), -1);
+    REQUIRE(-1 == file.get());
+  }
+}
@@ -0,0 +1,225 @@
+#include "scope_any.hpp"
+
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using scope::any_scope_exit;
+using scope::any_scope_fail;
+using scope::any_scope_success;
+
+namespace {
+any_scope_exit<> make_goodbye(std::ostream &out) {
+  return any_scope_exit{[&out] { out << "goodbye\n"; }};
+}
+
+struct connection {
+  std::ostream &out;
+  any_scope_exit<> on_close;
+
+  explicit connection(std::ostream &os)
+      : out{os}
+      , on_close{make_goodbye(os)} {}
+};
+} // namespace
+
+TEST_CASE("any_scope_exit returned from a function") {
+  std::ostringstream out{};
+  {
+    auto guard = make_goodbye(out);
+    REQUIRE(out.str().empty());
+  }
+  REQUIRE("goodbye\n" == out.str());
+}
+
+TEST_CASE("any_scope_exit as a member") {
+  std::ostringstream out{};
+  { connection c{out}; }
+  REQUIRE("goodbye\n" == out.str());
+}
+
+TEST_CASE("any_scope_exit moves the exit function") {
+  std::ostringstream out{};
+  {
+    any_scope_exit first{[&out] { out << "once\n"; }};
+    any_scope_exit second{std::move(first)};
+    any_scope_exit third{std::move(second)};
+  }
+  REQUIRE("once\n" == out.str());
+}
+
+TEST_CASE("any_scope_exit with an exit function larger than its buffer") {
+  std::ostringstream out{};
+  std::array<char, 128> large{};
+  large.fill('x');
+  {
+    any_scope_exit<16> guard{[&out, large] { out << large.size(); }};
+    any_scope_exit<16> moved{std::move(guard)};
+  }
+  REQUIRE("128" == out.str());
+}
+
+TEST_CASE("any_scope_exit release") {
+  std::ostringstream out{};
+  {
+    any_scope_exit guard{[&out] { out << "not called\n"; }};
+    guard.release();
+  }
+  REQUIRE(out.str().empty());
+}
+
+TEST_CASE("any_scope_fail and any_scope_success") {
+  std::ostringstream out{};
+  {
+    any_scope_fail fail{[&out] { out << "not called\n"; }};
+    any_scope_success success{[&out] { out << "success\n"; }};
+  }
+  REQUIRE("success\n" == out.str());
+  out.str("");
+  try {
+    any_scope_fail fail{[&out] { out << "fail\n"; }};
+    any_scope_success success{[&out] { out << "not called\n"; }};
+    throw 42;
+  } catch (int) {
+  }
+  REQUIRE("fail\n" == out.str());
+}
+
+namespace {
+struct throwing_copy {
+  std::ostream *out;
+  std::string what;
+  throwing_copy(std::ostream &os, std::string w)
+      : out{&os}
+      , what{std::move(w)} {}
+  throwing_copy(throwing_copy const &) {
+    throw 42;
+  }
+  void operator()() const {
+    *out << what;
+  }
+};
+
+// throws after having taken the text of the moved from one
+struct throwing_move {
+  std::ostream *out;
+  std::string what;
+  throwing_move(std::ostream &os, std::string w)
+      : out{&os}
+      , what{std::move(w)} {}
+  throwing_move(throwing_move const &) = default;
+  throwing_move(throwing_move &&that) noexcept(false)
+      : out{that.out}
+      , what{std::move(that.what)} {
+    throw 42;
+  }
+  void operator()() const {
+    *out << '[' << what << "]\n";
+  }
+};
+} // namespace
+
+TEST_CASE("any_scope_exit copies an exit function whose move can throw") {
+  std::ostringstream out{};
+  REQUIRE_NOTHROW(any_scope_exit{throwing_move{out, "intact"}});
+  REQUIRE("[intact]\n" == out.str());
+}
+
+TEST_CASE("any_scope_exit invokes an exit function it failed to store") {
+  std::ostringstream out{};
+  throwing_copy exit{out, "exit\n"};
+  REQUIRE_THROWS_AS(any_scope_exit{exit}, int);
+  throwing_copy fail{out, "fail\n"};
+  REQUIRE_THROWS_AS(any_scope_fail{fail}, int);
+  throwing_copy success{out, "not called\n"};
+  REQUIRE_THROWS_AS(any_scope_success{success}, int);
+  REQUIRE("exit\nfail\n" == out.str());
+}
+
+namespace {
+struct printing_deleter {
+  std::ostream *out;
+  void operator()(int r) const noexcept {
+    *out << "int " << r << '\n';
+  }
+  void operator()(char const *r) const noexcept {
+    *out << "string " << r << '\n';
+  }
+};
+
+// too large to be stored inline
+struct large_deleter {
+  std::ostream *out;
+  std::array<char, 64> padding{};
+  void operator()(int r) const noexcept {
+    *out << "large " << r << '\n';
+  }
+};
+} // namespace
+
+TEST_CASE("unique_any_resource owns resources of different types") {
+  using scope::unique_any_resource;
+  std::ostringstream out{};
+  {
+    std::vector<unique_any_resource<>> session{};
+    session.emplace_back(1, printing_deleter{&out});
+    session.emplace_back("log", printing_deleter{&out});
+    session.emplace_back(scope::unique_resource{2, large_deleter{&out}});
+    STATIC_REQUIRE(unique_any_resource<>::stores_inline<int, printing_deleter>);
+    STATIC_REQUIRE_FALSE(unique_any_resource<>::stores_inline<int, large_deleter>);
+    REQUIRE(out.str().empty());
+    while (!session.empty()) {
+      session.pop_back();
+    }
+  }
+  REQUIRE("large 2\nstring log\nint 1\n" == out.str());
+}
+
+TEST_CASE("unique_any_resource reset and release") {
+  using scope::unique_any_resource;
+  std::ostringstream out{};
+  {
+    unique_any_resource<> deleted{1, printing_deleter{&out}};
+    unique_any_resource<> released{2, printing_deleter{&out}};
+    unique_any_resource<> large_released{scope::unique_resource{3, large_deleter{&out}}};
+    deleted.reset();
+    REQUIRE("int 1\n" == out.str());
+    REQUIRE_FALSE(deleted);
+    released.release();
+    large_released.release();
+    REQUIRE_FALSE(released);
+    deleted.reset();
+  }
+  REQUIRE("int 1\n" == out.str());
+}
+
+TEST_CASE("unique_any_resource moves and gives typed access") {
+  using scope::unique_any_resource;
+  std::ostringstream out{};
+  {
+    unique_any_resource<> first{scope::unique_resource{1, printing_deleter{&out}}};
+    REQUIRE(first.target<int, printing_deleter>()->get() == 1);
+    REQUIRE(first.target<int, large_deleter>() == nullptr);
+    REQUIRE(std::as_const(first).target<char const *, printing_deleter>() == nullptr);
+    unique_any_resource<> second{std::move(first)};
+    REQUIRE_FALSE(first);
+    REQUIRE(second.target<int, printing_deleter>()->get() == 1);
+    unique_any_resource<> large{2, large_deleter{&out}};
+    second = std::move(large);
+    REQUIRE("int 1\n" == out.str());
+    REQUIRE(second.target<int, large_deleter>()->get() == 2);
+  }
+  REQUIRE("int 1\nlarge 2\n" == out.str());
+}
+
+TEST_CASE("unique_any_resource keeps a unique_resource that owns nothing silent") {
+  std::ostringstream out{};
+  {
+    scope::unique_any_resource<> invalid{scope::make_unique_resource_checked(-1, -1, printing_deleter{&out})};
+    REQUIRE(invalid);
+  }
+  REQUIRE(out.str().empty());
+}
@@ -0,0 +1,117 @@
+#include "scope_arena.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace {
+// counts the bytes allocated and not deallocated
+struct counting_resource : std::pmr::memory_resource {
+  std::size_t allocations{0};
+  std::size_t outstanding{0};
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    outstanding += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(std::pmr::memory_resource const &that) const noexcept override {
+    return this == &that;
+  }
+};
+} // namespace
+
+TEST_CASE("scope_arena rewinds at the end of SCOPE_ARENA") {
+  counting_resource upstream{};
+  {
+    scope::scope_arena arena{1024, &upstream};
+    auto const start = arena.position();
+    {
+      SCOPE_ARENA(arena);
+      std::pmr::vector<int> v{&arena};
+      v.resize(100);
+      CHECK(arena.position().position != start.position);
+    }
+    CHECK(arena.position().chunk == start.chunk);
+    CHECK(arena.position().position == start.position);
+    CHECK(upstream.allocations == 1);
+  }
+  CHECK(upstream.outstanding == 0);
+}
+
+TEST_CASE("nested arena scopes rewind to their own mark") {
+  scope::scope_arena arena{256};
+  SCOPE_ARENA(arena);
+  auto *outer            = static_cast<char *>(arena.allocate(16, 1));
+  auto const after_outer = arena.position();
+  {
+    SCOPE_ARENA(arena);
+    for (int i = 0; i < 100; ++i) {
+      CHECK(arena.allocate(64, 8) != nullptr); // needs chunks of its own
+    }
+  }
+  CHECK(arena.position().chunk == after_outer.chunk);
+  CHECK(arena.position().position == after_outer.position);
+  auto *next = static_cast<char *>(arena.allocate(16, 1));
+  CHECK(next == outer + 16);
+}
+
+TEST_CASE("scope_arena reuses the chunks it rewound") {
+  counting_resource upstream{};
+  scope::scope_arena arena{4096, &upstream};
+  for (int request = 0; request < 10; ++request) {
+    SCOPE_ARENA(arena);
+    std::pmr::string s{"a string that is too long for the small string optimization", &arena};
+    std::pmr::vector<std::pmr::string> strings{10, s, &arena};
+  }
+  CHECK(upstream.allocations == 1);
+  arena.release();
+  CHECK(upstream.outstanding == 0);
+}
+
+TEST_CASE("scope_arena allocates from its initial buffer first") {
+  counting_resource upstream{};
+  alignas(std::max_align_t) std::byte buffer[256];
+  scope::scope_arena arena{buffer, sizeof(buffer), 1024, &upstream};
+  {
+    SCOPE_ARENA(arena);
+    auto *p = arena.allocate(100, 16);
+    CHECK(p == buffer);
+    CHECK(upstream.allocations == 0);
+    auto *q = arena.allocate(200, 16);
+    CHECK(q != nullptr);
+    CHECK(upstream.allocations == 1);
+  }
+  CHECK(arena.allocate(8, 8) == buffer);
+}
+
+TEST_CASE("scope_arena honours the alignment") {
+  scope::scope_arena arena{128};
+  CHECK(arena.allocate(1, 1) != nullptr);
+  auto *p = arena.allocate(64, 64);
+  CHECK(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+  auto *large = arena.allocate(1000, 256);
+  CHECK(reinterpret_cast<std::uintptr_t>(large) % 256 == 0);
+}
+
+TEST_CASE("SCOPE_ARENA_DEFAULT makes the arena the thread's current resource") {
+  scope::scope_arena arena{};
+  CHECK(scope::current_memory_resource() == std::pmr::get_default_resource());
+  {
+    SCOPE_ARENA_DEFAULT(arena);
+    CHECK(scope::current_memory_resource() == &arena);
+    {
+      scope::scope_arena inner{};
+      SCOPE_ARENA_DEFAULT(inner);
+      CHECK(scope::current_memory_resource() == &inner);
+    }
+    CHECK(scope::current_memory_resource() == &arena);
+  }
+  CHECK(scope::current_memory_resource() == std::pmr::get_default_resource());
+}
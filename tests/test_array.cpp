@@ -0,0 +1,108 @@
+#include "scope_array.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using scope::unique_resource_array;
+
+namespace {
+struct single_deleter {
+  std::ostream *out;
+  void operator()(int r) const {
+    *out << r << ' ';
+  }
+};
+struct batch_deleter {
+  std::ostream *out;
+  void operator()(int r) const {
+    *out << "single " << r << ' ';
+  }
+  void operator()(int *first, int *last) const {
+    *out << "batch";
+    for (; first != last; ++first) {
+      *out << ' ' << *first;
+    }
+  }
+};
+} // namespace
+
+TEST_CASE("unique_resource_array deletes in reverse order without a batch deleter") {
+  std::ostringstream out{};
+  {
+    unique_resource_array<int, single_deleter> array{single_deleter{&out}};
+    for (auto i = 0; i < 4; ++i) {
+      array.push_back(i);
+    }
+    REQUIRE(4 == array.size());
+    REQUIRE(2 == array[2]);
+  }
+  REQUIRE("3 2 1 0 " == out.str());
+}
+
+TEST_CASE("unique_resource_array calls a batch deleter once") {
+  std::ostringstream out{};
+  {
+    unique_resource_array<int, batch_deleter> array{batch_deleter{&out}};
+    for (auto i = 0; i < 4; ++i) {
+      array.push_back(i);
+    }
+    array.reset();
+    REQUIRE(array.empty());
+    REQUIRE("batch 0 1 2 3" == out.str());
+    array.push_back(42);
+    array.release();
+  }
+  REQUIRE("batch 0 1 2 3" == out.str());
+}
+
+TEST_CASE("unique_resource_array push_back_checked") {
+  std::ostringstream out{};
+  {
+    unique_resource_array<int, single_deleter> array{single_deleter{&out}};
+    REQUIRE(array.push_back_checked(1, -1));
+    REQUIRE_FALSE(array.push_back_checked(-1, -1));
+    REQUIRE(1 == array.size());
+  }
+  REQUIRE("1 " == out.str());
+}
+
+TEST_CASE("unique_resource_array extract and move") {
+  std::ostringstream out{};
+  {
+    unique_resource_array<int, batch_deleter> array{batch_deleter{&out}};
+    array.push_back(1);
+    array.push_back(2);
+    array.push_back(3);
+    {
+      auto single = array.extract(0);
+      REQUIRE(1 == single.get());
+    }
+    REQUIRE("single 1 " == out.str());
+    auto moved = std::move(array);
+    REQUIRE(array.empty());
+    REQUIRE(std::vector<int>{3, 2} == std::vector<int>(moved.begin(), moved.end()));
+  }
+  REQUIRE("single 1 batch 3 2" == out.str());
+}
+
+#if defined(__linux__)
+TEST_CASE("unique_resource_array with close_fd_range") {
+  std::vector<int> fds{};
+  {
+    unique_resource_array<int, scope::close_fd_range> array{};
+    for (auto i = 0; i < 8; ++i) {
+      REQUIRE(array.push_back_checked(::open("/dev/null", O_RDONLY), -1));
+      fds.push_back(array[i]);
+    }
+  }
+  for (auto fd : fds) {
+    REQUIRE(-1 == ::fcntl(fd, F_GETFD));
+  }
+}
+#endif
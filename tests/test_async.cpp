@@ -0,0 +1,174 @@
+#include "scope_async.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using scope::backpressure;
+using scope::cleanup_executor;
+using scope::scope_exit_async;
+using scope::scope_fail_async;
+using scope::scope_success_async;
+
+namespace {
+// keeps the worker busy until open() is called
+struct gate {
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  bool entered{false};
+  bool opened{false};
+
+  void pass() {
+    std::unique_lock<std::mutex> lock{mutex};
+    entered = true;
+    cv.notify_all();
+    cv.wait(lock, [this] { return opened; });
+  }
+  void wait_entered() {
+    std::unique_lock<std::mutex> lock{mutex};
+    cv.wait(lock, [this] { return entered; });
+  }
+  void open() {
+    std::lock_guard<std::mutex> lock{mutex};
+    opened = true;
+    cv.notify_all();
+  }
+};
+} // namespace
+
+TEST_CASE("scope_exit_async runs the exit function on a worker") {
+  cleanup_executor executor{};
+  std::thread::id ran_on{};
+  {
+    scope_exit_async guard{executor, [&] { ran_on = std::this_thread::get_id(); }};
+  }
+  executor.drain();
+  CHECK(ran_on != std::thread::id{});
+  CHECK(ran_on != std::this_thread::get_id());
+}
+
+TEST_CASE("scope_exit_async does not post when released") {
+  cleanup_executor executor{};
+  std::atomic<int> runs{0};
+  {
+    scope_exit_async guard{executor, [&] { ++runs; }};
+    guard.release();
+  }
+  executor.drain();
+  CHECK(runs == 0);
+}
+
+TEST_CASE("scope_fail_async and scope_success_async decide when the scope ends") {
+  cleanup_executor executor{16, 2};
+  std::atomic<int> failed{0};
+  std::atomic<int> succeeded{0};
+  {
+    scope_fail_async on_fail{executor, [&] { ++failed; }};
+    scope_success_async on_success{executor, [&] { ++succeeded; }};
+  }
+  try {
+    scope_fail_async on_fail{executor, [&] { ++failed; }};
+    scope_success_async on_success{executor, [&] { ++succeeded; }};
+    throw std::runtime_error{"fail"};
+  } catch (std::runtime_error const &) {
+  }
+  executor.drain();
+  CHECK(failed == 1);
+  CHECK(succeeded == 1);
+}
+
+TEST_CASE("cleanup_executor runs the queued cleanups when it is destroyed") {
+  std::atomic<int> runs{0};
+  {
+    cleanup_executor executor{};
+    for (auto i = 0; i < 100; ++i) {
+      scope_exit_async guard{executor, [&] { ++runs; }};
+    }
+  }
+  CHECK(runs == 100);
+}
+
+TEST_CASE("cleanup_executor queues cleanups that do not fit the buffer") {
+  cleanup_executor executor{};
+  std::string large(1000, 'x');
+  std::atomic<std::size_t> length{0};
+  {
+    scope_exit_async guard{executor, [&length, large, more = large] { length = large.size() + more.size(); }};
+  }
+  executor.drain();
+  CHECK(length == 2000);
+}
+
+namespace {
+// throws after having taken the text of the moved from one
+struct throwing_move {
+  std::string *out;
+  std::string text;
+  throwing_move(std::string &o, std::string t)
+      : out{&o}
+      , text{std::move(t)} {}
+  throwing_move(throwing_move const &) = default;
+  throwing_move(throwing_move &&that) noexcept(false)
+      : out{that.out}
+      , text{std::move(that.text)} {
+    throw std::runtime_error{"move"};
+  }
+  void operator()() const {
+    *out += '[' + text + ']';
+  }
+};
+} // namespace
+
+TEST_CASE("cleanup_executor copies cleanups whose move can throw") {
+  std::string out{};
+  cleanup_executor executor{};
+  executor.post(throwing_move{out, "intact"});
+  executor.drain();
+  CHECK(out == "[intact]");
+}
+
+TEST_CASE("cleanup_executor drops and counts cleanups when the queue is full") {
+  gate g{};
+  std::atomic<int> runs{0};
+  cleanup_executor executor{1, 1, backpressure::drop};
+  executor.post([&] { g.pass(); });
+  g.wait_entered();
+  { scope_exit_async queued{executor, [&] { ++runs; }}; }
+  { scope_exit_async dropped{executor, [&] { ++runs; }}; }
+  CHECK(executor.dropped() == 1);
+  g.open();
+  executor.drain();
+  CHECK(runs == 1);
+}
+
+TEST_CASE("cleanup_executor runs cleanups inline when the queue is full") {
+  gate g{};
+  std::thread::id ran_on{};
+  cleanup_executor executor{1, 1, backpressure::run_inline};
+  executor.post([&] { g.pass(); });
+  g.wait_entered();
+  executor.post([] {});
+  { scope_exit_async inline_guard{executor, [&] { ran_on = std::this_thread::get_id(); }}; }
+  CHECK(ran_on == std::this_thread::get_id());
+  g.open();
+  executor.drain();
+  CHECK(executor.dropped() == 0);
+}
+
+TEST_CASE("cleanup_executor blocks when the queue is full") {
+  gate g{};
+  std::atomic<int> runs{0};
+  cleanup_executor executor{1, 1, backpressure::block};
+  executor.post([&] { g.pass(); });
+  g.wait_entered();
+  executor.post([&] { ++runs; });
+  std::thread poster{[&] { scope_exit_async blocked{executor, [&] { ++runs; }}; }};
+  g.open();
+  poster.join();
+  executor.drain();
+  CHECK(runs == 2);
+}
@@ -0,0 +1,99 @@
+#include "scope_coro.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using scope::co_scope_exit;
+using scope::co_scope_fail;
+using scope::co_scope_success;
+using scope::co_task;
+using scope::sync_wait;
+
+namespace {
+// resumes the awaiting coroutine on a new thread
+struct resume_elsewhere {
+  bool await_ready() const noexcept {
+    return false;
+  }
+  void await_suspend(std::coroutine_handle<> h) const {
+    std::thread{[h] { h.resume(); }}.detach();
+  }
+  void await_resume() const noexcept {}
+};
+
+co_task<void> async_log(std::string &log, char const *what) {
+  co_await resume_elsewhere{};
+  log += what;
+}
+
+co_task<int> guarded(std::string &log, bool fail) {
+  co_await co_scope_exit([&log] { log += "exit "; });
+  co_await co_scope_fail([&log] { log += "fail "; });
+  co_await co_scope_success([&log] { log += "success "; });
+  log += "body ";
+  co_await resume_elsewhere{};
+  if (fail)
+    throw std::runtime_error{"fail"};
+  co_return 42;
+}
+} // namespace
+
+TEST_CASE("co_scope_success runs when the body returns after a suspension") {
+  std::string log{};
+  CHECK(sync_wait(guarded(log, false)) == 42);
+  CHECK(log == "body success exit ");
+}
+
+TEST_CASE("co_scope_fail runs when the body throws after a suspension") {
+  std::string log{};
+  CHECK_THROWS_AS(sync_wait(guarded(log, true)), std::runtime_error);
+  CHECK(log == "body fail exit ");
+}
+
+TEST_CASE("co_scope_exit awaits a cleanup returning a co_task") {
+  std::string log{};
+  sync_wait([](std::string &log) -> co_task<void> {
+    co_await co_scope_exit([&log] { return async_log(log, "closed"); });
+    log += "used ";
+  }(log));
+  CHECK(log == "used closed");
+}
+
+TEST_CASE("co_cleanup release drops a registered cleanup") {
+  std::string log{};
+  sync_wait([](std::string &log) -> co_task<void> {
+    auto first = co_await co_scope_exit([&log] { log += "first "; });
+    co_await co_scope_exit([&log] { log += "second "; });
+    first.release();
+    co_return;
+  }(log));
+  CHECK(log == "second ");
+}
+
+TEST_CASE("a cleanup inside a nested co_task runs before the caller resumes") {
+  std::string log{};
+  sync_wait([](std::string &log) -> co_task<void> {
+    co_await [](std::string &log) -> co_task<void> {
+      co_await co_scope_exit([&log] { return async_log(log, "inner "); });
+      co_return;
+    }(log);
+    log += "outer";
+  }(log));
+  CHECK(log == "inner outer");
+}
+
+TEST_CASE("an exception from a cleanup is rethrown to the awaiting coroutine") {
+  std::string log{};
+  auto task = [](std::string &log) -> co_task<void> {
+    co_await co_scope_exit([&log] { log += "runs "; });
+    co_await co_scope_exit([]() -> co_task<void> {
+      throw std::logic_error{"cleanup"};
+      co_return;
+    });
+    co_return;
+  }(log);
+  CHECK_THROWS_AS(sync_wait(std::move(task)), std::logic_error);
+  CHECK(log == "runs ");
+}
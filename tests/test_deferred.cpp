@@ -0,0 +1,82 @@
+#include "scope_deferred.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+using scope::deferred_deleter;
+using scope::unique_resource;
+
+namespace {
+std::vector<int> deleted{};
+
+struct record {
+  void operator()(int r) const noexcept {
+    deleted.push_back(r);
+  }
+};
+
+template <std::size_t Threshold>
+using deferred = unique_resource<int, deferred_deleter<int, record, Threshold>>;
+} // namespace
+
+TEST_CASE("deferred_deleter does not delete on release") {
+  deleted.clear();
+  {
+    auto r = deferred<8>(1);
+    r.reset();
+    auto s = deferred<8>(2);
+  }
+  CHECK(deleted.empty());
+  CHECK(deferred_deleter<int, record, 8>::pending() == 2);
+  deferred_deleter<int, record, 8>::flush();
+  CHECK(deleted == std::vector<int>{2, 1});
+  CHECK(deferred_deleter<int, record, 8>::pending() == 0);
+}
+
+TEST_CASE("deferred_deleter deletes the batch when it is full") {
+  deleted.clear();
+  for (auto i = 0; i < 3; ++i) {
+    auto r = deferred<3>(i);
+  }
+  CHECK(deleted == std::vector<int>{2, 1, 0});
+  CHECK(deferred_deleter<int, record, 3>::pending() == 0);
+}
+
+TEST_CASE("deferred_deleter does not defer released resources") {
+  deleted.clear();
+  {
+    auto r = deferred<4>(1);
+    r.release();
+  }
+  CHECK(deferred_deleter<int, record, 4>::pending() == 0);
+}
+
+TEST_CASE("deferred_deleter deletes the batch of a thread when it exits") {
+  deleted.clear();
+  std::thread([] { auto r = deferred<5>(7); }).join();
+  CHECK(deleted == std::vector<int>{7});
+  CHECK(deferred_deleter<int, record, 5>::pending() == 0);
+}
+
+namespace {
+struct release_more;
+using chained = unique_resource<int, deferred_deleter<int, release_more, 2>>;
+
+// deleting one resource releases the next one
+struct release_more {
+  void operator()(int r) const noexcept {
+    deleted.push_back(r);
+    if (r > 0)
+      chained(r - 1);
+  }
+};
+} // namespace
+
+TEST_CASE("deferred_deleter deletes resources released while flushing") {
+  deleted.clear();
+  { auto r = chained(4); }
+  deferred_deleter<int, release_more, 2>::flush();
+  CHECK(deleted == std::vector<int>{4, 3, 2, 1, 0});
+  CHECK(deferred_deleter<int, release_more, 2>::pending() == 0);
+}
@@ -0,0 +1,127 @@
+#include "scope_epoch.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using scope::epoch_deleter;
+using scope::epoch_domain;
+
+namespace {
+std::atomic<int> deleted{0};
+
+struct count_delete {
+  void operator()(int *p) const noexcept {
+    delete p;
+    ++deleted;
+  }
+};
+} // namespace
+
+TEST_CASE("epoch_domain deletes a retired resource after the epoch advanced twice") {
+  deleted = 0;
+  epoch_domain domain{};
+  domain.retire(new int{1}, count_delete{});
+  domain.collect();
+  CHECK(deleted == 0);
+  domain.collect();
+  domain.collect();
+  CHECK(deleted == 1);
+}
+
+TEST_CASE("epoch_domain waits for read sections on other threads") {
+  deleted = 0;
+  epoch_domain domain{};
+  std::atomic<int> stage{0};
+  std::thread reader{[&] {
+    SCOPE_EPOCH(domain);
+    stage = 1;
+    while (stage != 2) {
+      std::this_thread::yield();
+    }
+  }};
+  while (stage != 1) {
+    std::this_thread::yield();
+  }
+  domain.retire(new int{1}, count_delete{});
+  for (auto i = 0; i < 10; ++i) {
+    domain.collect();
+  }
+  CHECK(deleted == 0);
+  stage = 2;
+  reader.join();
+  for (auto i = 0; i < 3; ++i) {
+    domain.collect();
+  }
+  CHECK(deleted == 1);
+}
+
+TEST_CASE("epoch_domain read sections nest") {
+  epoch_domain domain{};
+  auto outer = domain.pin();
+  {
+    SCOPE_EPOCH(domain);
+  }
+  CHECK(domain.try_advance());
+  CHECK_FALSE(domain.try_advance());
+}
+
+TEST_CASE("epoch_domain deletes the retired resources when it is destroyed") {
+  deleted = 0;
+  {
+    epoch_domain domain{};
+    domain.retire(new int{1}, count_delete{});
+    domain.retire(new int{2}, count_delete{});
+  }
+  CHECK(deleted == 2);
+}
+
+TEST_CASE("epoch_deleter retires the resource of a unique_resource") {
+  deleted = 0;
+  epoch_domain domain{};
+  {
+    scope::unique_resource<int *, epoch_deleter<count_delete>> owner{new int{1}, epoch_deleter<count_delete>{&domain}};
+  }
+  CHECK(deleted == 0);
+  for (auto i = 0; i < 3; ++i) {
+    domain.collect();
+  }
+  CHECK(deleted == 1);
+}
+
+TEST_CASE("epoch_domain protects readers of a shared pointer") {
+  deleted = 0;
+  std::atomic<int> reads{0};
+  {
+    epoch_domain domain{8};
+    std::atomic<int *> shared{new int{0}};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers{};
+    for (auto i = 0; i < 3; ++i) {
+      readers.emplace_back([&] {
+        while (!done) {
+          SCOPE_EPOCH(domain);
+          auto const *p = shared.load();
+          if (*p >= 0)
+            ++reads;
+        }
+      });
+    }
+    for (auto i = 1; i <= 1000; ++i) {
+      domain.retire(shared.exchange(new int{i}), count_delete{});
+      if (i % 100 == 0)
+        std::this_thread::yield();
+    }
+    while (reads == 0) {
+      std::this_thread::yield();
+    }
+    done = true;
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    domain.retire(shared.load(), count_delete{});
+  }
+  CHECK(deleted == 1001);
+}
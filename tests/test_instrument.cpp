@@ -0,0 +1,163 @@
+#define SCOPE_INSTRUMENTATION 1
+#include "scope_instrument.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using scope::scope_event;
+using scope::scope_record;
+
+namespace {
+std::vector<scope_record> records{};
+
+void keep(scope_record const &r) noexcept {
+  records.push_back(r);
+}
+
+// installs keep() for the lifetime of a test
+struct recording {
+  scope::scope_sink previous{scope::set_scope_sink(&keep)};
+  recording() {
+    records.clear();
+  }
+  ~recording() {
+    scope::set_scope_sink(previous);
+  }
+  static std::vector<scope_event> events() {
+    std::vector<scope_event> events{};
+    for (auto const &r : records) {
+      events.push_back(r.event);
+    }
+    return events;
+  }
+};
+
+struct close_fd {
+  void operator()(int) const noexcept {}
+};
+} // namespace
+
+TEST_CASE("scope_exit reports its construction and execution") {
+  recording rec{};
+  { scope::scope_exit guard{[] {}}; }
+  CHECK(recording::events() == std::vector<scope_event>{scope_event::constructed, scope_event::executed_on_exit});
+  CHECK(records[0].site == records[1].site);
+}
+
+TEST_CASE("a released scope_exit reports the release and no execution") {
+  recording rec{};
+  {
+    scope::scope_exit guard{[] {}};
+    guard.release();
+  }
+  CHECK(recording::events() == std::vector<scope_event>{scope_event::constructed, scope_event::released});
+}
+
+TEST_CASE("moving a guard reports nothing") {
+  recording rec{};
+  {
+    auto guard = scope::scope_exit{[] {}};
+    auto moved = std::move(guard);
+  }
+  CHECK(recording::events() == std::vector<scope_event>{scope_event::constructed, scope_event::executed_on_exit});
+}
+
+TEST_CASE("scope_fail and scope_success report which of them executed") {
+  recording rec{};
+  try {
+    scope::scope_fail on_fail{[] {}};
+    scope::scope_success on_success{[] {}};
+    throw std::runtime_error{"fail"};
+  } catch (std::runtime_error const &) {
+  }
+  CHECK(recording::events()
+        == std::vector<scope_event>{scope_event::constructed, scope_event::constructed, scope_event::executed_on_fail});
+}
+
+TEST_CASE("guards at different places are different sites") {
+  recording rec{};
+  { scope::scope_exit first{[] {}}; }
+  { scope::scope_exit second{[] {}}; }
+  REQUIRE(records.size() == 4);
+  CHECK(records[0].site != records[2].site);
+  CHECK(std::strlen(records[0].site->name) > 0);
+}
+
+TEST_CASE("unique_resource reports its lifecycle with the handle") {
+  recording rec{};
+  {
+    scope::unique_resource fd{3, close_fd{}};
+    fd.reset(4);
+    fd.release();
+    fd.reset(5);
+  }
+  CHECK(recording::events()
+        == std::vector<scope_event>{scope_event::constructed,
+                                    scope_event::deleted,
+                                    scope_event::reset,
+                                    scope_event::released,
+                                    scope_event::reset,
+                                    scope_event::deleted});
+  CHECK(records[0].handle == 3);
+  CHECK(records[1].handle == 3);
+  CHECK(records[2].handle == 4);
+  CHECK(records[5].handle == 5);
+}
+
+TEST_CASE("unique_resource does not report moves or the guards it uses") {
+  recording rec{};
+  {
+    scope::unique_resource fd{3, close_fd{}};
+    auto moved = std::move(fd);
+    auto checked = scope::make_unique_resource_checked(-1, -1, close_fd{});
+  }
+  CHECK(recording::events() == std::vector<scope_event>{scope_event::constructed, scope_event::deleted});
+}
+
+TEST_CASE("counting_sink adds up the events of a site") {
+  auto const previous = scope::counting_sink::install();
+  auto run            = [] { scope::scope_exit guard{[] {}}; };
+  for (auto i = 0; i < 10; ++i) {
+    run();
+  }
+  scope::set_scope_sink(previous);
+  auto const sites = scope::counting_sink::snapshot();
+  REQUIRE(sites.size() == 1);
+  CHECK(sites[0].count(scope_event::constructed) == 10);
+  CHECK(sites[0].count(scope_event::executed_on_exit) == 10);
+  std::uint64_t timed = 0;
+  for (auto n : sites[0].latency) {
+    timed += n;
+  }
+  CHECK(timed == 10);
+  CHECK(sites[0].percentile(0.5) <= sites[0].percentile(0.99));
+}
+
+namespace {
+struct close_late {
+  void operator()(int) const noexcept {}
+};
+} // namespace
+
+TEST_CASE("counting_sink drops the events of a thread after handing its counters back") {
+  auto const previous = scope::counting_sink::install();
+  std::thread{[] {
+    // constructed before the counters of the thread, so destroyed after them
+    static thread_local std::optional<scope::unique_resource<int, close_late>> late{};
+    late.emplace(1, close_late{});
+  }}.join();
+  scope::set_scope_sink(previous);
+  bool found = false;
+  for (auto const &site : scope::counting_sink::snapshot()) {
+    if (std::strstr(site.name, "close_late")) {
+      found = true;
+      CHECK(site.count(scope_event::constructed) == 1);
+      CHECK(site.count(scope_event::deleted) == 0);
+    }
+  }
+  CHECK(found);
+}
@@ -0,0 +1,88 @@
+#include "scope_mapping.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+// a file written for the duration of a test
+struct temporary_file {
+  std::string name;
+  temporary_file(std::string n, std::string const &content)
+      : name{std::move(n)} {
+    std::ofstream{name} << content;
+  }
+  ~temporary_file() {
+    ::unlink(name.c_str());
+  }
+};
+} // namespace
+
+TEST_CASE("unique_mapping maps a whole file") {
+  temporary_file file{"mapping.txt", "first line\nsecond line\n"};
+  auto mapping = scope::unique_mapping::map_file(file.name.c_str());
+  REQUIRE(mapping.mapped());
+  CHECK(mapping.size() == 23);
+  CHECK(mapping.view() == "first line\nsecond line\n");
+  CHECK(mapping.end() - mapping.begin() == 23);
+  CHECK(mapping.advise(scope::mapping_advice::sequential));
+  CHECK(mapping.advise(scope::mapping_advice::willneed, 11, 1000));
+}
+
+TEST_CASE("unique_mapping is empty if the mapping fails") {
+  auto mapping = scope::unique_mapping::map_file("nonexistingfile.txt");
+  CHECK(errno == ENOENT);
+  CHECK_FALSE(mapping.mapped());
+  CHECK(mapping.data() == nullptr);
+  CHECK(mapping.size() == 0);
+  CHECK(mapping.view().empty());
+  CHECK_FALSE(mapping.advise(scope::mapping_advice::normal));
+}
+
+TEST_CASE("unique_resource owns the result of mmap only if it succeeded") {
+  auto failed = scope::make_unique_resource_checked(
+      ::mmap(nullptr, 0, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0), MAP_FAILED, scope::munmap_deleter{0});
+  CHECK(failed.get() == MAP_FAILED);
+  static_assert(sizeof(failed) == sizeof(void *) + sizeof(std::size_t));
+}
+
+TEST_CASE("unique_mapping moves the ownership of the mapping") {
+  auto mapping = scope::unique_mapping::anonymous(4096, scope::map_populate);
+  REQUIRE(mapping.mapped());
+  mapping.data()[0] = std::byte{42};
+  auto moved        = std::move(mapping);
+  CHECK_FALSE(mapping.mapped());
+  REQUIRE(moved.mapped());
+  CHECK(moved.data()[0] == std::byte{42});
+  moved.reset();
+  CHECK_FALSE(moved.mapped());
+}
+
+TEST_CASE("unique_mapping release gives up the mapping") {
+  auto mapping                 = scope::unique_mapping::anonymous(4096);
+  auto const [address, length] = mapping.release();
+  CHECK_FALSE(mapping.mapped());
+  CHECK(length == 4096);
+  CHECK(::munmap(address, length) == 0);
+}
+
+#if defined(__linux__)
+TEST_CASE("unique_mapping grows with remap and keeps its content") {
+  auto mapping = scope::unique_mapping::anonymous(4096);
+  REQUIRE(mapping.mapped());
+  std::memset(mapping.data(), 'x', 4096);
+  REQUIRE(mapping.remap(1 << 20));
+  CHECK(mapping.size() == 1 << 20);
+  CHECK(mapping.data()[4095] == std::byte{'x'});
+  CHECK(mapping.data()[4096] == std::byte{0});
+  mapping.data()[(1 << 20) - 1] = std::byte{1};
+  CHECK(mapping.advise(scope::mapping_advice::random));
+  REQUIRE(mapping.remap(4096));
+  CHECK(mapping.size() == 4096);
+
+  scope::unique_mapping empty{};
+  CHECK_FALSE(empty.remap(4096));
+}
+#endif
@@ -0,0 +1,127 @@
+#include "scope_pool.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+// counts the live instances
+struct buffer {
+  static inline int live = 0;
+  std::vector<char> bytes;
+
+  explicit buffer(std::size_t size = 16)
+      : bytes(size) {
+    ++live;
+  }
+  buffer(buffer const &) = delete;
+  ~buffer() {
+    --live;
+  }
+};
+
+struct throwing {
+  throwing() {
+    throw std::runtime_error{"no"};
+  }
+};
+} // namespace
+
+TEST_CASE("object_pool recycles released objects") {
+  scope::object_pool<buffer> pool{};
+  buffer *first = nullptr;
+  {
+    auto b = pool.acquire(64);
+    first       = b.get();
+    b->bytes[0] = 'x';
+    CHECK(buffer::live == 1);
+  }
+  CHECK(buffer::live == 1);
+  auto again = pool.acquire();
+  CHECK(again.get() == first);
+  CHECK(again->bytes.size() == 64);
+  CHECK(again->bytes[0] == 'x');
+  auto other = pool.acquire();
+  CHECK(other.get() != first);
+  CHECK(buffer::live == 2);
+}
+
+TEST_CASE("object_pool destroys its idle objects when destroyed") {
+  {
+    scope::object_pool<buffer> pool{};
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+  }
+  CHECK(buffer::live == 0);
+}
+
+TEST_CASE("object_pool overflows to the shared stack and then destroys") {
+  scope::object_pool<buffer> pool{4, 4};
+  {
+    std::vector<scope::object_pool<buffer>::pointer> held{};
+    for (int i = 0; i < 16; ++i) {
+      held.push_back(pool.acquire());
+    }
+    CHECK(buffer::live == 16);
+  }
+  // the thread keeps up to 4, the shared stack up to 4
+  CHECK(pool.idle() <= 4);
+  CHECK(buffer::live <= 8);
+  CHECK(buffer::live > 4);
+  pool.trim();
+  CHECK(pool.idle() == 0);
+  CHECK(buffer::live == 0);
+}
+
+TEST_CASE("object_pool hands objects released on another thread out again") {
+  scope::object_pool<buffer> pool{64, 2};
+  std::vector<buffer *> addresses{};
+  std::thread{[&] {
+    std::vector<scope::object_pool<buffer>::pointer> held{};
+    for (int i = 0; i < 8; ++i) {
+      held.push_back(pool.acquire());
+      addresses.push_back(held.back().get());
+    }
+  }}.join();
+  // the thread cache went to the shared stack when the thread exited
+  CHECK(pool.idle() == 8);
+  CHECK(buffer::live == 8);
+  std::vector<scope::object_pool<buffer>::pointer> held{};
+  for (int i = 0; i < 8; ++i) {
+    held.push_back(pool.acquire());
+    CHECK(std::find(addresses.begin(), addresses.end(), held.back().get()) != addresses.end());
+  }
+  CHECK(buffer::live == 8);
+}
+
+TEST_CASE("object_pool does not leak if constructing an object throws") {
+  scope::object_pool<throwing> pool{};
+  CHECK_THROWS_AS(pool.acquire(), std::runtime_error);
+}
+
+TEST_CASE("object_pool is safe to use from many threads") {
+  scope::object_pool<buffer> pool{16, 4};
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool] {
+      std::vector<scope::object_pool<buffer>::pointer> held{};
+      for (int i = 0; i < 2000; ++i) {
+        held.push_back(pool.acquire());
+        if (held.size() > static_cast<std::size_t>(i % 7))
+          held.clear();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  pool.trim();
+  CHECK(pool.idle() == 0);
+  CHECK(buffer::live == 0);
+}
+
+TEST_CASE("a pooled object takes no more space than a pointer and the pool") {
+  static_assert(sizeof(scope::object_pool<buffer>::pointer) == 2 * sizeof(void *));
+}
@@ -0,0 +1,154 @@
+#define SCOPE_INSTRUMENTATION 1
+#include "scope_registry.hpp"
+#if __has_include(<sys/mman.h>)
+#include "scope_mapping.hpp"
+#endif
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+struct close_socket {
+  void operator()(int) const noexcept {}
+};
+struct close_pipe {
+  void operator()(int) const noexcept {}
+};
+using socket_t = scope::unique_resource<int, close_socket>;
+using pipe_t   = scope::unique_resource<int, close_pipe>;
+
+// restores the sink installed before the registry
+struct registered {
+  scope::scope_sink previous{scope::set_scope_sink(nullptr)};
+  explicit registered(bool track_handles = false) {
+    scope::set_scope_sink(previous);
+    scope::resource_registry::install(track_handles);
+  }
+  ~registered() {
+    scope::set_scope_sink(previous);
+  }
+};
+} // namespace
+
+TEST_CASE("resource_registry counts the live resources per type") {
+  registered reg{};
+  auto const sockets = scope::resource_registry::count<int, close_socket>();
+  auto const pipes   = scope::resource_registry::count<int, close_pipe>();
+  {
+    socket_t a{1, close_socket{}};
+    socket_t b{2, close_socket{}};
+    pipe_t c{3, close_pipe{}};
+    CHECK(scope::resource_registry::count<int, close_socket>() == sockets + 2);
+    CHECK(scope::resource_registry::count<int, close_pipe>() == pipes + 1);
+    b.release();
+    CHECK(scope::resource_registry::count<int, close_socket>() == sockets + 1);
+    auto moved = std::move(a);
+    CHECK(scope::resource_registry::count<int, close_socket>() == sockets + 1);
+    moved.reset(4);
+    CHECK(scope::resource_registry::count<int, close_socket>() == sockets + 1);
+  }
+  CHECK(scope::resource_registry::count<int, close_socket>() == sockets);
+  CHECK(scope::resource_registry::count<int, close_pipe>() == pipes);
+
+  bool found = false;
+  for (auto const &type : scope::resource_registry::counts()) {
+    if (std::strstr(type.name, "close_socket") && std::strstr(type.name, "unique_resource")) {
+      found = true;
+      CHECK(type.live == sockets);
+    }
+  }
+  CHECK(found);
+}
+
+TEST_CASE("resource_registry does not count invalid resources") {
+  registered reg{};
+  auto const sockets = scope::resource_registry::count<int, close_socket>();
+  auto checked       = scope::make_unique_resource_checked(-1, -1, close_socket{});
+  CHECK(scope::resource_registry::count<int, close_socket>() == sockets);
+}
+
+namespace {
+struct close_file {
+  void operator()(int) const noexcept {}
+};
+} // namespace
+
+template <>
+struct scope::resource_traits<int, close_file> {
+  static constexpr int invalid() noexcept {
+    return -1;
+  }
+};
+
+TEST_CASE("resource_registry does not count resources holding their invalid value") {
+  registered reg{true};
+  auto const files = scope::resource_registry::count<int, close_file>();
+  {
+    scope::unique_resource<int, close_file> invalid{-1, close_file{}};
+    scope::unique_resource<int, close_file> reset{7, close_file{}};
+    reset.reset(-1);
+    CHECK(scope::resource_registry::count<int, close_file>() == files);
+    CHECK(scope::resource_registry::held<int, close_file>().empty());
+  }
+  CHECK(scope::resource_registry::count<int, close_file>() == files);
+  CHECK(scope::resource_registry::held<int, close_file>().empty());
+}
+
+#if __has_include(<sys/mman.h>)
+TEST_CASE("resource_registry does not count empty mappings") {
+  registered reg{true};
+  auto const mappings = scope::resource_registry::count<void *, scope::munmap_deleter>();
+  {
+    scope::unique_mapping empty{};
+    CHECK(scope::resource_registry::count<void *, scope::munmap_deleter>() == mappings);
+  }
+  CHECK(scope::resource_registry::count<void *, scope::munmap_deleter>() == mappings);
+  CHECK(scope::resource_registry::held<void *, scope::munmap_deleter>().empty());
+}
+#endif
+
+TEST_CASE("resource_registry lists the resources still held with their acquisition site") {
+  registered reg{true};
+  auto const line = __LINE__ + 1;
+  socket_t leaked{41, close_socket{}};
+  {
+    socket_t closed{42, close_socket{}};
+  }
+  auto const held = scope::resource_registry::held<int, close_socket>();
+  REQUIRE(held.size() == 1);
+  CHECK(held[0].handle == 41);
+  CHECK(held[0].where.line == line);
+  CHECK(std::strstr(held[0].where.file, "test_registry.cpp"));
+  CHECK(scope::resource_registry::held<int, close_pipe>().empty());
+
+  leaked.reset();
+  CHECK(scope::resource_registry::held<int, close_socket>().empty());
+}
+
+TEST_CASE("resource_registry adds up the counts of all threads") {
+  registered reg{true};
+  auto const sockets = scope::resource_registry::count<int, close_socket>();
+  std::vector<socket_t> kept{};
+  for (int i = 0; i < 8; ++i) {
+    kept.emplace_back(1000 + i, close_socket{});
+  }
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([t] {
+      for (int i = 0; i < 1000; ++i) {
+        socket_t s{t * 1000 + i, close_socket{}};
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // released on another thread than the one that acquired them
+  std::thread{[&kept] {
+    kept.erase(kept.begin() + 4, kept.end());
+  }}.join();
+  CHECK(scope::resource_registry::count<int, close_socket>() == sockets + 4);
+  CHECK(scope::resource_registry::held<int, close_socket>().size() == 4);
+}
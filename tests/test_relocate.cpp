@@ -0,0 +1,181 @@
+#include "scope_relocate.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using scope::is_trivially_relocatable_v;
+using scope::relocating_vector;
+
+namespace {
+// records the handles it deletes in a vector of the test case
+struct handle_deleter {
+  std::vector<int> *deleted;
+  void operator()(int handle) const noexcept {
+    deleted->push_back(handle);
+  }
+};
+
+void delete_handle(int) noexcept {}
+
+using handle = scope::unique_resource<int, handle_deleter>;
+
+// counts its moves, which relocation by copying bytes skips
+struct counted {
+  static inline int moves = 0;
+  int value;
+  explicit counted(int v) noexcept
+      : value{v} {}
+  counted(counted &&that) noexcept
+      : value{that.value} {
+    ++moves;
+  }
+};
+
+// throws from its constructor for 42
+struct throwing_on_42 {
+  int value;
+  explicit throwing_on_42(int v)
+      : value{v} {
+    if (v == 42)
+      throw std::runtime_error{"42"};
+  }
+};
+
+struct relocatable_counted : counted {
+  using counted::counted;
+};
+} // namespace
+
+template <>
+struct scope::is_trivially_relocatable<relocatable_counted> : std::true_type {};
+
+TEST_CASE("guards and unique_resource are trivially relocatable if their members are") {
+  int i{};
+  auto by_reference = [&i] { ++i; };
+  auto by_value     = [s = std::string{}] { (void)s; };
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::scope_exit<decltype(by_reference)>>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::scope_fail<decltype(by_reference)>>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::scope_success<decltype(by_reference)>>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::scope_fail_on<bool, decltype(by_reference)>>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::scope_exit<void (&)()>>);
+  STATIC_REQUIRE_FALSE(is_trivially_relocatable_v<scope::scope_exit<decltype(by_value)>>);
+  STATIC_REQUIRE_FALSE(is_trivially_relocatable_v<scope::scope_exit<std::function<void()>>>);
+
+  STATIC_REQUIRE(is_trivially_relocatable_v<handle>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::unique_resource<int, void (*)(int)>>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::unique_resource_fn<int, &delete_handle>>);
+  STATIC_REQUIRE(is_trivially_relocatable_v<scope::unique_resource<int &, handle_deleter>>);
+  STATIC_REQUIRE_FALSE(is_trivially_relocatable_v<scope::unique_resource<int, std::function<void(int)>>>);
+  STATIC_REQUIRE_FALSE(is_trivially_relocatable_v<scope::unique_resource<std::string, void (*)(std::string)>>);
+}
+
+TEST_CASE("relocating_vector grows without deleting resources") {
+  std::vector<int> deleted{};
+  {
+    relocating_vector<handle> handles{};
+    for (auto i = 0; i < 1000; ++i) {
+      handles.emplace_back(i, handle_deleter{&deleted});
+    }
+    REQUIRE(handles.size() == 1000);
+    REQUIRE(handles.capacity() >= 1000);
+    REQUIRE(deleted.empty());
+    for (auto i = 0; i < 1000; ++i) {
+      REQUIRE(handles[static_cast<std::size_t>(i)].get() == i);
+    }
+  }
+  REQUIRE(deleted.size() == 1000);
+  REQUIRE(deleted.front() == 999);
+  REQUIRE(deleted.back() == 0);
+}
+
+TEST_CASE("relocating_vector copies the bytes of trivially relocatable elements") {
+  counted::moves = 0;
+  relocating_vector<relocatable_counted> relocatable{};
+  for (auto i = 0; i < 100; ++i) {
+    relocatable.emplace_back(i);
+  }
+  REQUIRE(counted::moves == 0);
+
+  relocating_vector<counted> moved{};
+  for (auto i = 0; i < 100; ++i) {
+    moved.emplace_back(i);
+  }
+  REQUIRE(counted::moves > 0);
+  for (auto i = 0; i < 100; ++i) {
+    REQUIRE(relocatable[static_cast<std::size_t>(i)].value == i);
+    REQUIRE(moved[static_cast<std::size_t>(i)].value == i);
+  }
+}
+
+TEST_CASE("relocating_vector moves elements that are not trivially relocatable") {
+  relocating_vector<std::unique_ptr<std::string>> strings{};
+  for (auto i = 0; i < 100; ++i) {
+    strings.push_back(std::make_unique<std::string>(std::to_string(i)));
+  }
+  strings.reserve(1000);
+  REQUIRE(strings.capacity() == 1000);
+  REQUIRE(*strings[42] == "42");
+  REQUIRE(*strings.back() == "99");
+}
+
+TEST_CASE("relocating_vector::erase deletes the resource and closes the gap") {
+  std::vector<int> deleted{};
+  relocating_vector<handle> handles{};
+  for (auto i = 0; i < 5; ++i) {
+    handles.emplace_back(i, handle_deleter{&deleted});
+  }
+  auto *next = handles.erase(handles.begin() + 1);
+  REQUIRE(deleted == std::vector<int>{1});
+  REQUIRE(next->get() == 2);
+  REQUIRE(handles.size() == 4);
+  handles.erase(handles.end() - 1);
+  REQUIRE(deleted == std::vector<int>{1, 4});
+  REQUIRE(handles[0].get() == 0);
+  REQUIRE(handles[1].get() == 2);
+  REQUIRE(handles[2].get() == 3);
+  handles.pop_back();
+  handles.clear();
+  REQUIRE(deleted == std::vector<int>{1, 4, 3, 2, 0});
+  REQUIRE(handles.empty());
+}
+
+TEST_CASE("relocating_vector::emplace_back can take one of its elements when it grows") {
+  relocating_vector<std::string> strings{};
+  strings.emplace_back("first, long enough not to be stored in place");
+  while (strings.size() != strings.capacity()) {
+    strings.emplace_back("filler");
+  }
+  strings.push_back(strings[0]);
+  REQUIRE(strings.back() == strings[0]);
+  REQUIRE(strings.back() == "first, long enough not to be stored in place");
+}
+
+TEST_CASE("relocating_vector is unchanged if constructing an element throws when it grows") {
+  relocating_vector<throwing_on_42> values{};
+  while (values.size() != values.capacity() || values.empty()) {
+    values.emplace_back(static_cast<int>(values.size()));
+  }
+  auto const capacity = values.capacity();
+  REQUIRE_THROWS_AS(values.emplace_back(42), std::runtime_error);
+  REQUIRE(values.capacity() == capacity);
+  REQUIRE(values.size() == capacity);
+  REQUIRE(values.back().value == static_cast<int>(capacity) - 1);
+}
+
+TEST_CASE("moving a relocating_vector hands its resources over") {
+  std::vector<int> deleted{};
+  relocating_vector<handle> handles{};
+  handles.emplace_back(1, handle_deleter{&deleted});
+  relocating_vector<handle> moved{std::move(handles)};
+  REQUIRE(handles.empty());
+  REQUIRE(moved.size() == 1);
+  relocating_vector<handle> assigned{};
+  assigned.emplace_back(2, handle_deleter{&deleted});
+  assigned = std::move(moved);
+  REQUIRE(deleted == std::vector<int>{2});
+  REQUIRE(assigned[0].get() == 1);
+}
@@ -0,0 +1,157 @@
+#include "scope_shared.hpp"
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+using scope::local_shared_resource;
+using scope::shared_resource;
+
+namespace {
+// records the handles it deletes in a vector of the test case
+struct handle_deleter {
+  std::vector<int> *deleted;
+  void operator()(int handle) const noexcept {
+    deleted->push_back(handle);
+  }
+};
+
+// -1 is invalid, see the resource_traits below
+struct checked_deleter {
+  std::vector<int> *deleted;
+  void operator()(int handle) const noexcept {
+    deleted->push_back(handle);
+  }
+};
+
+struct counting_deleter {
+  std::atomic<int> *deletions;
+  void operator()(int) const noexcept {
+    deletions->fetch_add(1, std::memory_order_relaxed);
+  }
+};
+} // namespace
+
+template <>
+struct scope::resource_traits<int, checked_deleter> {
+  static constexpr int invalid() noexcept {
+    return -1;
+  }
+};
+
+TEST_CASE("shared_resource deletes its resource when the last copy is gone") {
+  std::vector<int> deleted{};
+  {
+    shared_resource first{42, handle_deleter{&deleted}};
+    REQUIRE(first.use_count() == 1);
+    {
+      auto second = first;
+      REQUIRE(first.use_count() == 2);
+      REQUIRE(second.get() == 42);
+    }
+    REQUIRE(deleted.empty());
+    auto third = std::move(first);
+    REQUIRE_FALSE(first);
+    REQUIRE(first.use_count() == 0);
+    REQUIRE(third.use_count() == 1);
+    REQUIRE(deleted.empty());
+  }
+  REQUIRE(deleted == std::vector<int>{42});
+}
+
+TEST_CASE("shared_resource holds a pointer only") {
+  STATIC_REQUIRE(sizeof(shared_resource<int, handle_deleter>) == sizeof(void *));
+  STATIC_REQUIRE(sizeof(local_shared_resource<int, void (*)(int)>) == sizeof(void *));
+  STATIC_REQUIRE(scope::is_trivially_relocatable_v<shared_resource<int, handle_deleter>>);
+}
+
+TEST_CASE("shared_resource takes the resource of a unique_resource") {
+  std::vector<int> deleted{};
+  scope::unique_resource<int, handle_deleter> unique{1, handle_deleter{&deleted}};
+  shared_resource shared{std::move(unique)};
+  unique.reset();
+  REQUIRE(deleted.empty());
+  REQUIRE(shared.get() == 1);
+  shared.reset();
+  REQUIRE(deleted == std::vector<int>{1});
+  REQUIRE_FALSE(shared);
+}
+
+TEST_CASE("shared_resource owns nothing if the unique_resource does not") {
+  std::vector<int> deleted{};
+  {
+    scope::unique_resource<int, handle_deleter> released{1, handle_deleter{&deleted}};
+    released.release();
+    shared_resource from_released{std::move(released)};
+    REQUIRE_FALSE(from_released);
+    REQUIRE(from_released.use_count() == 0);
+    scope::unique_resource<int, checked_deleter> invalid{-1, checked_deleter{&deleted}};
+    shared_resource from_invalid{std::move(invalid)};
+    REQUIRE_FALSE(from_invalid);
+    shared_resource<int, checked_deleter> constructed_invalid{-1, checked_deleter{&deleted}};
+    REQUIRE_FALSE(constructed_invalid);
+  }
+  REQUIRE(deleted.empty());
+}
+
+TEST_CASE("assigning a shared_resource drops the reference it had") {
+  std::vector<int> deleted{};
+  shared_resource<int, handle_deleter> first{1, handle_deleter{&deleted}};
+  shared_resource<int, handle_deleter> second{2, handle_deleter{&deleted}};
+  auto copy = second;
+  second    = first;
+  REQUIRE(deleted.empty());
+  REQUIRE(first.use_count() == 2);
+  copy = second;
+  REQUIRE(deleted == std::vector<int>{2});
+  REQUIRE(first.use_count() == 3);
+  auto const &alias = copy;
+  copy              = alias;
+  REQUIRE(first.use_count() == 3);
+}
+
+TEST_CASE("make_shared_resource_checked owns nothing for the invalid value") {
+  std::vector<int> deleted{};
+  {
+    auto invalid = scope::make_shared_resource_checked(-1, -1, handle_deleter{&deleted});
+    REQUIRE_FALSE(invalid);
+    auto valid = scope::make_shared_resource_checked(3, -1, handle_deleter{&deleted});
+    REQUIRE(valid);
+    REQUIRE(valid.get() == 3);
+  }
+  REQUIRE(deleted == std::vector<int>{3});
+}
+
+TEST_CASE("local_shared_resource counts references without atomics") {
+  std::vector<int> deleted{};
+  {
+    local_shared_resource<int, handle_deleter> first{7, handle_deleter{&deleted}};
+    std::vector<local_shared_resource<int, handle_deleter>> copies(10, first);
+    REQUIRE(first.use_count() == 11);
+    copies.clear();
+    REQUIRE(first.use_count() == 1);
+  }
+  REQUIRE(deleted == std::vector<int>{7});
+}
+
+TEST_CASE("shared_resource copies can be dropped concurrently") {
+  std::atomic<int> deletions{0};
+  for (auto round = 0; round < 100; ++round) {
+    shared_resource<int, counting_deleter> shared{round, counting_deleter{&deletions}};
+    std::vector<std::thread> threads{};
+    for (auto t = 0; t < 4; ++t) {
+      threads.emplace_back([copy = shared] {
+        for (auto i = 0; i < 100; ++i) {
+          auto inner = copy;
+          (void)inner;
+        }
+      });
+    }
+    shared.reset();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+  REQUIRE(deletions == 100);
+}
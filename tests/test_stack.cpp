@@ -0,0 +1,207 @@
+#include "scope_stack.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using scope::scope_fail_stack;
+using scope::scope_stack;
+using scope::scope_success_stack;
+
+TEST_CASE("scope_stack runs its exit functions in reverse order") {
+  std::ostringstream out{};
+  {
+    scope_stack stack;
+    for (auto i = 0; i < 3; ++i) {
+      stack.push([&out, i] { out << i; });
+    }
+    REQUIRE(3 == stack.size());
+  }
+  REQUIRE("210" == out.str());
+}
+
+TEST_CASE("scope_stack spills to the heap when the inline buffer is full") {
+  std::ostringstream out{};
+  {
+    scope_stack<64> stack;
+    for (auto i = 0; i < 100; ++i) {
+      stack.push([&out, i, s = std::string(i % 7, 'x')] { out << i << s.size() << ' '; });
+    }
+    REQUIRE(100 == stack.size());
+  }
+  std::ostringstream expected{};
+  for (auto i = 99; i >= 0; --i) {
+    expected << i << i % 7 << ' ';
+  }
+  REQUIRE(expected.str() == out.str());
+}
+
+TEST_CASE("scope_stack release drops the exit functions") {
+  std::ostringstream out{};
+  auto counter = std::make_shared<int>(0);
+  {
+    scope_stack<64> stack;
+    for (auto i = 0; i < 20; ++i) {
+      stack.push([&out, counter] { out << "not called"; });
+    }
+    REQUIRE(21 == counter.use_count());
+    stack.release();
+    REQUIRE(stack.empty());
+    REQUIRE(1 == counter.use_count());
+    stack.push([&out] { out << "called"; });
+  }
+  REQUIRE("called" == out.str());
+}
+
+TEST_CASE("scope_fail_stack and scope_success_stack") {
+  std::ostringstream out{};
+  {
+    scope_fail_stack fail;
+    scope_success_stack success;
+    fail.push([&out] { out << "not called\n"; });
+    success.push([&out] { out << "success\n"; });
+  }
+  REQUIRE("success\n" == out.str());
+  out.str("");
+  try {
+    scope_fail_stack fail;
+    scope_success_stack success;
+    fail.push([&out] { out << "fail 1\n"; });
+    fail.push([&out] { out << "fail 2\n"; });
+    success.push([&out] { out << "not called\n"; });
+    throw 42;
+  } catch (int) {
+  }
+  REQUIRE("fail 2\nfail 1\n" == out.str());
+}
+
+namespace {
+struct throwing_copy {
+  std::ostream *out;
+  explicit throwing_copy(std::ostream &os)
+      : out{&os} {}
+  throwing_copy(throwing_copy const &) {
+    throw 42;
+  }
+  void operator()() const {
+    *out << "called\n";
+  }
+};
+
+// throws after having taken the text of the moved from one
+struct throwing_move {
+  std::ostream *out;
+  std::string text;
+  throwing_move(std::ostream &os, std::string t)
+      : out{&os}
+      , text{std::move(t)} {}
+  throwing_move(throwing_move const &) = default;
+  throwing_move(throwing_move &&that) noexcept(false)
+      : out{that.out}
+      , text{std::move(that.text)} {
+    throw 42;
+  }
+  void operator()() const {
+    *out << '[' << text << "]\n";
+  }
+};
+} // namespace
+
+TEST_CASE("scope_stack invokes an exit function it failed to store") {
+  std::ostringstream out{};
+  throwing_copy fun{out};
+  {
+    scope_stack stack;
+    REQUIRE_THROWS_AS(stack.push(fun), int);
+    REQUIRE(stack.empty());
+  }
+  REQUIRE("called\n" == out.str());
+  out.str("");
+  {
+    scope_success_stack stack;
+    REQUIRE_THROWS_AS(stack.push(fun), int);
+  }
+  REQUIRE(out.str().empty());
+}
+
+TEST_CASE("scope_stack copies an exit function whose move can throw") {
+  std::ostringstream out{};
+  {
+    scope_stack stack;
+    REQUIRE_NOTHROW(stack.push(throwing_move{out, "intact"}));
+    REQUIRE(out.str().empty());
+  }
+  REQUIRE("[intact]\n" == out.str());
+}
+
+TEST_CASE("scope_transaction rolls back when it is not committed") {
+  std::string state{};
+  {
+    scope::scope_transaction tx;
+    for (auto c : std::string{"abc"}) {
+      state.push_back(c);
+      tx.on_rollback([&state] { state.pop_back(); });
+    }
+    REQUIRE("abc" == state);
+    REQUIRE(3 == tx.size());
+  }
+  REQUIRE(state.empty());
+  try {
+    scope::scope_transaction tx;
+    state.push_back('a');
+    tx.on_rollback([&state] { state.pop_back(); });
+    throw 42;
+  } catch (int) {
+  }
+  REQUIRE(state.empty());
+}
+
+TEST_CASE("scope_transaction commit drops the undo actions") {
+  std::string state{};
+  {
+    scope::scope_transaction<64> tx;
+    for (auto i = 0; i < 50; ++i) {
+      state.push_back('x');
+      tx.on_rollback([&state] { state.pop_back(); });
+    }
+    tx.commit();
+    REQUIRE(tx.empty());
+  }
+  REQUIRE(50 == state.size());
+}
+
+TEST_CASE("scope_transaction explicit rollback") {
+  std::ostringstream out{};
+  {
+    scope::scope_transaction tx;
+    tx.on_rollback([&out] { out << "1"; });
+    tx.on_rollback([&out] { out << "2"; });
+    tx.rollback();
+    REQUIRE("21" == out.str());
+    tx.on_rollback([&out] { out << "not called"; });
+    tx.commit();
+  }
+  REQUIRE("21" == out.str());
+}
+
+TEST_CASE("scope_transaction rollback propagates an exception from an undo action") {
+  std::ostringstream out{};
+  auto const destroyed = std::make_shared<int>(0); // use_count() drops when the copy is destroyed
+  {
+    scope::scope_transaction tx;
+    tx.on_rollback([&out] { out << "1"; });
+    tx.on_rollback([&out, destroyed] {
+      out << "2";
+      throw 42;
+    });
+    tx.on_rollback([&out] { out << "3"; });
+    REQUIRE(2 == destroyed.use_count());
+    REQUIRE_THROWS_AS(tx.rollback(), int);
+    REQUIRE("32" == out.str());
+    REQUIRE(1 == destroyed.use_count());
+    REQUIRE(1 == tx.size());
+    tx.on_rollback([&out] { out << "4"; });
+  }
+  REQUIRE("3241" == out.str());
+}
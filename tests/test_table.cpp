@@ -0,0 +1,158 @@
+#include "scope_table.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using scope::resource_table;
+
+namespace {
+// records the handles it deletes in a vector of the test case
+struct handle_deleter {
+  std::vector<int> *deleted;
+  void operator()(int handle) const noexcept {
+    deleted->push_back(handle);
+  }
+};
+
+using table = resource_table<int, handle_deleter>;
+} // namespace
+
+TEST_CASE("resource_table finds resources by handle") {
+  std::vector<int> deleted{};
+  {
+    table sockets{};
+    auto const first  = sockets.emplace(1, handle_deleter{&deleted});
+    auto const second = sockets.insert(scope::unique_resource{2, handle_deleter{&deleted}});
+    REQUIRE(first);
+    REQUIRE(first != second);
+    REQUIRE(sockets.size() == 2);
+    REQUIRE(sockets.find(first)->get() == 1);
+    REQUIRE(sockets.find(second)->get() == 2);
+    REQUIRE(sockets.find(table::handle{}) == nullptr);
+    REQUIRE(table::handle{second.value()} == second);
+    REQUIRE(deleted.empty());
+  }
+  REQUIRE(deleted.size() == 2);
+}
+
+TEST_CASE("resource_table::erase deletes the resource and makes its handle stale") {
+  std::vector<int> deleted{};
+  table sockets{};
+  auto const first  = sockets.emplace(1, handle_deleter{&deleted});
+  auto const second = sockets.emplace(2, handle_deleter{&deleted});
+  auto const third  = sockets.emplace(3, handle_deleter{&deleted});
+  REQUIRE(sockets.erase(first));
+  REQUIRE(deleted == std::vector<int>{1});
+  REQUIRE_FALSE(sockets.erase(first));
+  REQUIRE_FALSE(sockets.contains(first));
+  REQUIRE(sockets.find(first) == nullptr);
+  REQUIRE(sockets.find(second)->get() == 2);
+  REQUIRE(sockets.find(third)->get() == 3);
+
+  // the slot of first is reused with another generation
+  auto const fourth = sockets.emplace(4, handle_deleter{&deleted});
+  REQUIRE(fourth != first);
+  REQUIRE(sockets.find(first) == nullptr);
+  REQUIRE(sockets.find(fourth)->get() == 4);
+  REQUIRE(deleted == std::vector<int>{1});
+}
+
+TEST_CASE("resource_table gives up a resource moved out of it") {
+  std::vector<int> deleted{};
+  table sockets{};
+  auto const h = sockets.emplace(1, handle_deleter{&deleted});
+  {
+    auto kept = std::move(*sockets.find(h));
+    REQUIRE(sockets.erase(h));
+    REQUIRE(deleted.empty());
+  }
+  REQUIRE(deleted == std::vector<int>{1});
+}
+
+TEST_CASE("resource_table iterates over its resources and their handles") {
+  std::vector<int> deleted{};
+  table sockets{};
+  std::vector<table::handle> handles{};
+  for (auto i = 0; i < 10; ++i) {
+    handles.push_back(sockets.emplace(i, handle_deleter{&deleted}));
+  }
+  sockets.erase(handles[3]);
+  sockets.erase(handles[7]);
+  auto sum = 0;
+  for (auto const &socket : sockets) {
+    sum += socket.get();
+  }
+  REQUIRE(sum == 45 - 3 - 7);
+  for (std::size_t i = 0; i < sockets.size(); ++i) {
+    REQUIRE(sockets.find(sockets.handle_at(i)) == sockets.begin() + i);
+  }
+  sockets.clear();
+  REQUIRE(sockets.empty());
+  REQUIRE(deleted.size() == 10);
+  for (auto h : handles) {
+    REQUIRE_FALSE(sockets.contains(h));
+  }
+}
+
+TEST_CASE("resource_table with 32 bit handles retires exhausted slots") {
+  std::vector<int> deleted{};
+  resource_table<int, handle_deleter, std::uint32_t> sockets{};
+  STATIC_REQUIRE(sizeof(decltype(sockets)::handle) == sizeof(std::uint32_t));
+  std::vector<decltype(sockets)::handle> stale{};
+  // a slot has 4095 generations
+  for (auto i = 0; i < 5000; ++i) {
+    auto const h = sockets.emplace(i, handle_deleter{&deleted});
+    REQUIRE(std::find(stale.begin(), stale.end(), h) == stale.end());
+    stale.push_back(h);
+    REQUIRE(sockets.erase(h));
+  }
+  REQUIRE(deleted.size() == 5000);
+  for (auto h : stale) {
+    REQUIRE_FALSE(sockets.contains(h));
+  }
+}
+
+TEST_CASE("resource_table agrees with an unordered_map") {
+  std::vector<int> deleted{};
+  table sockets{};
+  std::unordered_map<std::uint64_t, int> model{};
+  std::vector<table::handle> handles{};
+  std::mt19937 random{42};
+  for (auto i = 0; i < 20000; ++i) {
+    if (handles.empty() || random() % 3 != 0) {
+      auto const h = sockets.emplace(i, handle_deleter{&deleted});
+      model.emplace(h.value(), i);
+      handles.push_back(h);
+    } else {
+      auto const victim = random() % handles.size();
+      auto const h      = handles[victim];
+      REQUIRE(sockets.erase(h) == (model.erase(h.value()) == 1));
+      if (random() % 2 == 0) {
+        handles[victim] = handles.back();
+        handles.pop_back();
+      }
+    }
+  }
+  REQUIRE(sockets.size() == model.size());
+  for (auto const &[value, resource] : model) {
+    REQUIRE(sockets.find(table::handle{value})->get() == resource);
+  }
+}
+
+TEST_CASE("moving a resource_table hands its resources over") {
+  std::vector<int> deleted{};
+  table sockets{};
+  auto const h = sockets.emplace(1, handle_deleter{&deleted});
+  table moved{std::move(sockets)};
+  REQUIRE(sockets.empty());
+  REQUIRE(moved.find(h)->get() == 1);
+  table assigned{};
+  assigned.emplace(2, handle_deleter{&deleted});
+  assigned = std::move(moved);
+  REQUIRE(deleted == std::vector<int>{2});
+  REQUIRE(assigned.find(h)->get() == 1);
+}